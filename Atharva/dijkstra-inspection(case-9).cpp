@@ -18,11 +18,141 @@ static vector<tuple<int,int,double>> load_edges_generic(const string &path){
     return out;
 }
 
+enum class QueueKind { Heap, Dial, Radix };
+static const char* queue_name(QueueKind q){ return q==QueueKind::Dial ? "dial" : q==QueueKind::Radix ? "radix" : "heap"; }
+
+struct Workspace {
+    static constexpr double INF = 1e18;
+    vector<double> dist;
+    vector<int> par, stamp, goal, order;
+    int epoch = 0, settled = 0;
+    vector<pair<double,int>> heap;
+    vector<vector<int>> dial;
+    vector<pair<uint64_t,int>> radix[65];
+    void prepare(int n){
+        if((int)dist.size() != n){ dist.assign(n, INF); par.assign(n, -1); stamp.assign(n, 0); goal.assign(n, 0); epoch = 0; }
+        if(++epoch == INT_MAX){ fill(stamp.begin(), stamp.end(), 0); fill(goal.begin(), goal.end(), 0); epoch = 1; }
+        settled = 0;
+        order.clear();
+    }
+    double get(int v) const { return stamp[v] == epoch ? dist[v] : INF; }
+};
+
 struct Graph {
     int n;
     vector<vector<Edge>> adj;
+    bool intWeights = true;
+    uint64_t maxW = 0;
     Graph(int n=0): n(n), adj(n) {}
-    void add_edge(int u,int v,double w){ if(u>=0 && v>=0){ if(u>=n || v>=n){ int newn = max(n, max(u+1,v+1)); adj.resize(newn); n=newn; } adj[u].push_back({v,w}); adj[v].push_back({u,w}); } }
+    void add_edge(int u,int v,double w){
+        if(u>=0 && v>=0){
+            if(u>=n || v>=n){ int newn = max(n, max(u+1,v+1)); adj.resize(newn); n=newn; }
+            adj[u].push_back({v,w}); adj[v].push_back({u,w});
+            if(w < 0 || w != floor(w) || w > 9e15) intWeights = false; else maxW = max(maxW, (uint64_t)w);
+        }
+    }
+    double set_weight(int u,int v,double w){
+        double old = 1e18; bool found = false;
+        for(auto &e: adj[u]) if(e.v==v){ old = min(old, e.w); e.w = w; found = true; }
+        for(auto &e: adj[v]) if(e.v==u) e.w = w;
+        if(!found){ adj[u].push_back({v,w}); adj[v].push_back({u,w}); }
+        if(w != floor(w) || w > 9e15) intWeights = false; else maxW = max(maxW, (uint64_t)w);
+        return old;
+    }
+    pair<int64_t,uint64_t> fingerprint() const {
+        int64_t m = 0; uint64_t sum = 0;
+        for(int u=0;u<n;++u) for(auto &e: adj[u]){
+            uint64_t bits; memcpy(&bits, &e.w, sizeof bits);
+            uint64_t x = ((uint64_t)u << 32 | (uint32_t)e.v) * 0x9E3779B97F4A7C15ULL ^ bits;
+            x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL; x ^= x >> 27; x *= 0x94D049BB133111EBULL; x ^= x >> 31;
+            sum += x; ++m;
+        }
+        return {m / 2, sum};
+    }
+    QueueKind usable(QueueKind q) const {
+        if(!intWeights) return QueueKind::Heap;
+        if(q == QueueKind::Dial && maxW > (1u<<20)) return QueueKind::Radix;
+        return q;
+    }
+    int search(Workspace &ws, int s, const vector<int> &targets = {}, QueueKind q = QueueKind::Heap){
+        ws.prepare(n);
+        int pending = 0;
+        for(int t: targets) if(t>=0 && t<n && ws.goal[t] != ws.epoch){ ws.goal[t] = ws.epoch; ++pending; }
+        bool full = targets.empty();
+        if(!full && pending == 0) return 0;
+        ws.stamp[s] = ws.epoch; ws.dist[s] = 0; ws.par[s] = -1;
+        auto settle = [&](int u){
+            ++ws.settled;
+            ws.order.push_back(u);
+            if(ws.goal[u] == ws.epoch){ ws.goal[u] = 0; --pending; }
+            return full || pending > 0;
+        };
+        auto relax = [&](int u, double d, auto &&push){
+            for(auto &e: adj[u]){
+                double nd = d + e.w;
+                if(nd < ws.get(e.v)){ ws.stamp[e.v] = ws.epoch; ws.dist[e.v] = nd; ws.par[e.v] = u; push(nd, e.v); }
+            }
+        };
+        switch(usable(q)){
+        case QueueKind::Heap: {
+            auto &h = ws.heap; h.clear();
+            greater<pair<double,int>> cmp;
+            auto push = [&](double d, int v){ h.push_back({d, v}); push_heap(h.begin(), h.end(), cmp); };
+            push(0, s);
+            while(!h.empty()){
+                pop_heap(h.begin(), h.end(), cmp);
+                auto [d,u] = h.back(); h.pop_back();
+                if(d != ws.dist[u]) continue;
+                if(!settle(u)) break;
+                relax(u, d, push);
+            }
+            break;
+        }
+        case QueueKind::Dial: {
+            size_t C = maxW + 1;
+            if(ws.dial.size() != C) ws.dial.assign(C, {}); else for(auto &b: ws.dial) b.clear();
+            size_t live = 0;
+            auto push = [&](double d, int v){ ws.dial[(uint64_t)d % C].push_back(v); ++live; };
+            push(0, s);
+            for(uint64_t cur = 0; live; ){
+                auto &b = ws.dial[cur % C];
+                if(b.empty()){ ++cur; continue; }
+                int u = b.back(); b.pop_back(); --live;
+                if(ws.dist[u] != (double)cur) continue;
+                if(!settle(u)) break;
+                relax(u, (double)cur, push);
+            }
+            break;
+        }
+        case QueueKind::Radix: {
+            for(auto &b: ws.radix) b.clear();
+            uint64_t last = 0; size_t live = 0;
+            auto bucket = [&](uint64_t k){ return k == last ? 0 : 64 - __builtin_clzll(k ^ last); };
+            auto push = [&](double d, int v){ uint64_t k = (uint64_t)d; ws.radix[bucket(k)].push_back({k, v}); ++live; };
+            push(0, s);
+            while(live){
+                if(ws.radix[0].empty()){
+                    int i = 1; while(ws.radix[i].empty()) ++i;
+                    last = UINT64_MAX;
+                    for(auto &e: ws.radix[i]) last = min(last, e.first);
+                    for(auto &e: ws.radix[i]) ws.radix[bucket(e.first)].push_back(e);
+                    ws.radix[i].clear();
+                }
+                auto [k,u] = ws.radix[0].back(); ws.radix[0].pop_back(); --live;
+                if(ws.dist[u] != (double)k) continue;
+                if(!settle(u)) break;
+                relax(u, (double)k, push);
+            }
+            break;
+        }
+        }
+        return ws.settled;
+    }
+    vector<int> path_to(const Workspace &ws, int t) const {
+        vector<int> path; if(t<0||t>=n||ws.get(t) > 1e17) return path;
+        for(int cur=t; cur!=-1; cur=ws.par[cur]) path.push_back(cur);
+        reverse(path.begin(), path.end()); return path;
+    }
     pair<vector<double>, vector<int>> dijkstra(int s){
         const double INF = 1e18;
         vector<double> dist(n, INF);
@@ -47,6 +177,426 @@ struct Graph {
     }
 };
 
+struct ContractionHierarchy {
+    static constexpr double INF = 1e18;
+    struct Arc { int to; double w; int mid; };
+    int n = 0;
+    pair<int64_t,uint64_t> source{0, 0};
+    vector<int> rank;
+    vector<int> upOff;
+    vector<Arc> up;
+    vector<double> dist[2];
+    vector<int> par[2];
+    vector<int> stamp[2];
+    int epoch = 0;
+    bool ready() const { return n > 0 && (int)rank.size() == n; }
+    void build(const Graph &g, int settleLimit=500, int simulateLimit=40){
+        n = g.n;
+        source = g.fingerprint();
+        vector<vector<Arc>> adj(n);
+        for(int u=0;u<n;++u) for(auto &e: g.adj[u]) if(e.v != u) add_arc(adj[u], e.v, e.w, -1);
+        vector<char> done(n, 0);
+        vector<int> deleted(n, 0);
+        vector<vector<Arc>> upAdj(n);
+        vector<double> wd(n, INF);
+        vector<int> ws(n, 0), wt(n, 0);
+        int wepoch = 0;
+        auto witness = [&](int src, int skip, double limit, int maxSettled, const vector<Arc> &nb, size_t from){
+            ++wepoch;
+            int pending = 0;
+            for(size_t j=from;j<nb.size();++j) if(wt[nb[j].to] != wepoch){ wt[nb[j].to] = wepoch; ++pending; }
+            using P = pair<double,int>;
+            priority_queue<P, vector<P>, greater<P>> pq;
+            wd[src] = 0; ws[src] = wepoch; pq.push({0, src});
+            int settled = 0;
+            while(!pq.empty() && settled < maxSettled && pending > 0){
+                auto [d,u] = pq.top(); pq.pop();
+                if(d != wd[u]) continue;
+                if(d > limit) break;
+                ++settled;
+                if(wt[u] == wepoch){ wt[u] = 0; --pending; }
+                for(auto &a: adj[u]){
+                    if(done[a.to] || a.to == skip) continue;
+                    double nd = d + a.w;
+                    if(ws[a.to] != wepoch || nd < wd[a.to]){ ws[a.to] = wepoch; wd[a.to] = nd; pq.push({nd, a.to}); }
+                }
+            }
+        };
+        auto shortcuts = [&](int v, bool apply){
+            vector<Arc> nb;
+            for(auto &a: adj[v]) if(!done[a.to]) nb.push_back(a);
+            int added = 0;
+            for(size_t i=0;i<nb.size();++i){
+                double limit = 0;
+                for(size_t j=i+1;j<nb.size();++j) limit = max(limit, nb[i].w + nb[j].w);
+                if(i+1 >= nb.size()) break;
+                witness(nb[i].to, v, limit, apply ? settleLimit : simulateLimit, nb, i+1);
+                for(size_t j=i+1;j<nb.size();++j){
+                    double via = nb[i].w + nb[j].w;
+                    int a = nb[i].to, b = nb[j].to;
+                    if(ws[b] == wepoch && wd[b] <= via) continue;
+                    ++added;
+                    if(apply){ add_arc(adj[a], b, via, v); add_arc(adj[b], a, via, v); }
+                }
+            }
+            return make_pair(added, (int)nb.size());
+        };
+        auto priority = [&](int v){
+            auto r = shortcuts(v, false);
+            return (r.first - r.second) * 4 + deleted[v] * 2;
+        };
+        using Q = pair<int,int>;
+        priority_queue<Q, vector<Q>, greater<Q>> pq;
+        for(int v=0;v<n;++v) pq.push({priority(v), v});
+        rank.assign(n, 0);
+        int next = 0;
+        while(!pq.empty()){
+            auto [p,v] = pq.top(); pq.pop();
+            if(done[v]) continue;
+            int fresh = priority(v);
+            if(!pq.empty() && fresh > pq.top().first){ pq.push({fresh, v}); continue; }
+            shortcuts(v, true);
+            for(auto &a: adj[v]) if(!done[a.to]){
+                upAdj[v].push_back(a);
+                ++deleted[a.to];
+                auto &lst = adj[a.to];
+                lst.erase(remove_if(lst.begin(), lst.end(), [&](const Arc &x){ return x.to == v; }), lst.end());
+            }
+            adj[v].clear();
+            adj[v].shrink_to_fit();
+            done[v] = 1;
+            rank[v] = next++;
+        }
+        upOff.assign(n+1, 0);
+        up.clear();
+        for(int v=0;v<n;++v){ upOff[v] = up.size(); for(auto &a: upAdj[v]) up.push_back(a); }
+        upOff[n] = up.size();
+        reset_workspace();
+    }
+    static void add_arc(vector<Arc> &lst, int to, double w, int mid){
+        for(auto &a: lst) if(a.to == to){ if(w < a.w){ a.w = w; a.mid = mid; } return; }
+        lst.push_back({to, w, mid});
+    }
+    void reset_workspace(){
+        for(int d=0;d<2;++d){ dist[d].assign(n, INF); par[d].assign(n, -1); stamp[d].assign(n, 0); }
+        epoch = 0;
+    }
+    const Arc* find_arc(int lo, int hi) const {
+        for(int p=upOff[lo];p<upOff[lo+1];++p) if(up[p].to == hi) return &up[p];
+        return nullptr;
+    }
+    void unpack(int a, int b, vector<int> &out) const {
+        int lo = rank[a] < rank[b] ? a : b, hi = lo == a ? b : a;
+        const Arc *arc = find_arc(lo, hi);
+        if(!arc || arc->mid < 0){ out.push_back(b); return; }
+        unpack(a, arc->mid, out);
+        unpack(arc->mid, b, out);
+    }
+    double query(int s, int t, vector<int> *path){
+        if(++epoch == INT_MAX){ for(int d=0;d<2;++d) fill(stamp[d].begin(), stamp[d].end(), 0); epoch = 1; }
+        using P = pair<double,int>;
+        priority_queue<P, vector<P>, greater<P>> pq[2];
+        int src[2] = {s, t};
+        for(int d=0;d<2;++d){ dist[d][src[d]] = 0; par[d][src[d]] = -1; stamp[d][src[d]] = epoch; pq[d].push({0, src[d]}); }
+        double best = INF; int meet = -1;
+        auto get = [&](int d, int v){ return stamp[d][v] == epoch ? dist[d][v] : INF; };
+        while(!pq[0].empty() || !pq[1].empty()){
+            double top0 = pq[0].empty() ? INF : pq[0].top().first, top1 = pq[1].empty() ? INF : pq[1].top().first;
+            if(min(top0, top1) >= best) break;
+            int d = top0 <= top1 ? 0 : 1;
+            auto [du,u] = pq[d].top(); pq[d].pop();
+            if(du != get(d,u)) continue;
+            double other = get(1-d, u);
+            if(other < INF && du + other < best){ best = du + other; meet = u; }
+            bool stalled = false;
+            for(int p=upOff[u];p<upOff[u+1] && !stalled;++p){
+                const Arc &a = up[p];
+                if(get(d, a.to) + a.w < du) stalled = true;
+            }
+            if(stalled) continue;
+            for(int p=upOff[u];p<upOff[u+1];++p){
+                const Arc &a = up[p];
+                double nd = du + a.w;
+                if(nd < get(d, a.to)){ stamp[d][a.to] = epoch; dist[d][a.to] = nd; par[d][a.to] = u; pq[d].push({nd, a.to}); }
+            }
+        }
+        if(path){
+            path->clear();
+            if(meet < 0) return best;
+            vector<int> chain;
+            for(int v=meet; v!=-1; v=par[0][v]) chain.push_back(v);
+            reverse(chain.begin(), chain.end());
+            path->push_back(s);
+            for(size_t i=1;i<chain.size();++i) unpack(chain[i-1], chain[i], *path);
+            for(int v=meet; par[1][v]!=-1; v=par[1][v]) unpack(v, par[1][v], *path);
+        }
+        return best;
+    }
+    bool save(const string &file) const {
+        ofstream out(file, ios::binary);
+        if(!out.is_open()) return false;
+        const char magic[4] = {'C','H','v','2'};
+        int64_t hdr[4] = {n, (int64_t)up.size(), source.first, (int64_t)source.second};
+        out.write(magic, 4);
+        out.write((const char*)hdr, sizeof(hdr));
+        out.write((const char*)rank.data(), n*sizeof(int));
+        out.write((const char*)upOff.data(), (n+1)*sizeof(int));
+        out.write((const char*)up.data(), up.size()*sizeof(Arc));
+        return (bool)out;
+    }
+    bool load(const string &file, const Graph &g){
+        ifstream in(file, ios::binary);
+        char magic[4];
+        int64_t hdr[4];
+        if(!in.read(magic, 4) || memcmp(magic, "CHv2", 4) != 0) return false;
+        auto fp = g.fingerprint();
+        if(!in.read((char*)hdr, sizeof(hdr)) || hdr[0] != g.n || hdr[1] < 0) return false;
+        if(hdr[2] != fp.first || (uint64_t)hdr[3] != fp.second) return false;
+        n = (int)hdr[0];
+        source = fp;
+        rank.resize(n); upOff.resize(n+1); up.resize(hdr[1]);
+        in.read((char*)rank.data(), n*sizeof(int));
+        in.read((char*)upOff.data(), (n+1)*sizeof(int));
+        in.read((char*)up.data(), up.size()*sizeof(Arc));
+        if(!in || upOff[n] != (int)up.size()){ n = 0; rank.clear(); return false; }
+        reset_workspace();
+        return true;
+    }
+};
+
+struct TourPlanner {
+    Graph &g;
+    Workspace ws;
+    vector<int> rowOf;
+    vector<vector<double>> rows;
+    vector<vector<int>> orders;
+    size_t maxRows;
+    long long computed = 0;
+    TourPlanner(Graph &g, size_t budgetMB=256): g(g), maxRows(max<size_t>(16, budgetMB*1024*1024 / ((size_t)max(1,g.n)*(sizeof(double)+sizeof(int))))) {}
+    void clear(){ rowOf.assign(g.n, -1); rows.clear(); orders.clear(); }
+    int row(int v, QueueKind q){
+        if((int)rowOf.size() != g.n) clear();
+        if(rowOf[v] >= 0) return rowOf[v];
+        if(rows.size() >= maxRows) clear();
+        g.search(ws, v, {}, q); ++computed;
+        vector<double> r(g.n);
+        for(int i=0;i<g.n;++i) r[i] = ws.get(i);
+        rowOf[v] = rows.size();
+        rows.push_back(move(r)); orders.push_back(ws.order);
+        return rowOf[v];
+    }
+    struct Result { vector<int> tour; double greedy = 0, length = 0; int moves = 0; };
+    Result plan(int start, int k, QueueKind q){
+        Result res;
+        vector<int> pool(g.n), pos(g.n);
+        iota(pool.begin(), pool.end(), 0); iota(pos.begin(), pos.end(), 0);
+        auto take = [&](int v){ int i = pos[v], last = pool.back(); pool[i] = last; pos[last] = i; pool.pop_back(); pos[v] = -1; };
+        res.tour.push_back(start); take(start);
+        int cur = start;
+        for(int step=0; step<k && !pool.empty(); ++step){
+            int r = row(cur, q);
+            int best = -1;
+            for(int v: orders[r]) if(pos[v] >= 0){ best = v; break; }
+            if(best == -1) break;
+            res.greedy += rows[r][best];
+            res.tour.push_back(best); take(best);
+            cur = best;
+        }
+        int m = res.tour.size();
+        vector<double> D((size_t)m*m);
+        for(int i=0;i<m;++i){ int r = row(res.tour[i], q); for(int j=0;j<m;++j) D[(size_t)i*m+j] = rows[r][res.tour[j]]; }
+        auto d = [&](int a, int b){ return D[(size_t)a*m+b]; };
+        vector<int> p(m); iota(p.begin(), p.end(), 0);
+        const double eps = 1e-9;
+        for(bool improved = true; improved && res.moves < 100000; ){
+            improved = false;
+            for(int i=1;i+1<m;++i) for(int j=i+1;j<m;++j){
+                int a = p[i-1], b = p[i], c = p[j];
+                double delta = d(a,c) - d(a,b);
+                if(j+1 < m) delta += d(b,p[j+1]) - d(c,p[j+1]);
+                if(delta < -eps){ reverse(p.begin()+i, p.begin()+j+1); improved = true; ++res.moves; }
+            }
+            for(int len=1; len<=3; ++len) for(int i=1;i+len<=m;++i){
+                int s0 = p[i], se = p[i+len-1], prev = p[i-1], next = i+len<m ? p[i+len] : -1;
+                double gain = d(prev,s0) + (next>=0 ? d(se,next) - d(prev,next) : 0);
+                int bestJ = -1; bool bestRev = false; double bestDelta = -eps;
+                for(int j=0;j<m;++j){
+                    if(j >= i-1 && j <= i+len-1) continue;
+                    int a = p[j], b = j+1<m ? p[j+1] : -1;
+                    double fwd = d(a,s0) + (b>=0 ? d(se,b) - d(a,b) : 0) - gain;
+                    double rev = d(a,se) + (b>=0 ? d(s0,b) - d(a,b) : 0) - gain;
+                    if(fwd < bestDelta){ bestDelta = fwd; bestJ = j; bestRev = false; }
+                    if(rev < bestDelta){ bestDelta = rev; bestJ = j; bestRev = true; }
+                }
+                if(bestJ < 0) continue;
+                vector<int> seg(p.begin()+i, p.begin()+i+len);
+                if(bestRev) reverse(seg.begin(), seg.end());
+                int after = p[bestJ];
+                p.erase(p.begin()+i, p.begin()+i+len);
+                int at = find(p.begin(), p.end(), after) - p.begin() + 1;
+                p.insert(p.begin()+at, seg.begin(), seg.end());
+                improved = true; ++res.moves;
+            }
+        }
+        vector<int> tour(m);
+        for(int i=0;i<m;++i) tour[i] = res.tour[p[i]];
+        res.tour = tour;
+        for(int i=0;i+1<m;++i) res.length += d(p[i], p[i+1]);
+        return res;
+    }
+};
+
+struct DynamicSSSP {
+    static constexpr double INF = 1e18;
+    struct Tree { int src; vector<double> dist; vector<int> par; long long lastUse = 0; };
+    Graph &g;
+    size_t capacity;
+    int promoteAfter;
+    vector<Tree> trees;
+    unordered_map<int,int> hits;
+    vector<int> mark, nodes;
+    int markEpoch = 0;
+    long long tick = 0;
+    using P = pair<double,int>;
+    priority_queue<P, vector<P>, greater<P>> pq;
+    DynamicSSSP(Graph &g, size_t capacity=8, int promoteAfter=2): g(g), capacity(capacity), promoteAfter(promoteAfter) {}
+    Tree* touch(int s, Workspace &ws, QueueKind q){
+        ++tick;
+        for(auto &t: trees) if(t.src == s){ t.lastUse = tick; return &t; }
+        if(capacity == 0 || ++hits[s] < promoteAfter) return nullptr;
+        g.search(ws, s, {}, q);
+        Tree t; t.src = s; t.lastUse = tick; t.dist.resize(g.n); t.par.resize(g.n);
+        for(int i=0;i<g.n;++i){ t.dist[i] = ws.get(i); t.par[i] = t.dist[i] < INF ? ws.par[i] : -1; }
+        if(trees.size() >= capacity){
+            auto lru = min_element(trees.begin(), trees.end(), [](const Tree &a, const Tree &b){ return a.lastUse < b.lastUse; });
+            *lru = move(t); return &*lru;
+        }
+        trees.push_back(move(t));
+        return &trees.back();
+    }
+    vector<int> path(const Tree &t, int v) const {
+        vector<int> out; if(t.dist[v] >= INF) return out;
+        for(int cur=v; cur!=-1; cur=t.par[cur]) out.push_back(cur);
+        reverse(out.begin(), out.end()); return out;
+    }
+    long long settle(Tree &t){
+        long long touched = 0;
+        while(!pq.empty()){
+            auto [d,x] = pq.top(); pq.pop();
+            if(d != t.dist[x]) continue;
+            ++touched;
+            for(auto &e: g.adj[x]) if(d + e.w < t.dist[e.v]){ t.dist[e.v] = d + e.w; t.par[e.v] = x; pq.push({t.dist[e.v], e.v}); }
+        }
+        return touched;
+    }
+    long long decrease(Tree &t, int u, int v, double w){
+        auto seed = [&](int a, int b){ if(t.dist[a] + w < t.dist[b]){ t.dist[b] = t.dist[a] + w; t.par[b] = a; pq.push({t.dist[b], b}); } };
+        seed(u, v); seed(v, u);
+        return settle(t);
+    }
+    long long increase(Tree &t, int u, int v){
+        int child = t.par[v]==u ? v : t.par[u]==v ? u : -1;
+        if(child < 0) return 0;
+        if((int)mark.size() != g.n) mark.assign(g.n, 0);
+        if(++markEpoch == INT_MAX){ fill(mark.begin(), mark.end(), 0); markEpoch = 1; }
+        nodes.clear(); nodes.push_back(child); mark[child] = markEpoch;
+        for(size_t i=0;i<nodes.size();++i){
+            int y = nodes[i];
+            for(auto &e: g.adj[y]) if(t.par[e.v]==y && mark[e.v]!=markEpoch){ mark[e.v] = markEpoch; nodes.push_back(e.v); }
+        }
+        for(int x: nodes){ t.dist[x] = INF; t.par[x] = -1; }
+        for(int x: nodes){
+            for(auto &e: g.adj[x]) if(mark[e.v]!=markEpoch && t.dist[e.v] + e.w < t.dist[x]){ t.dist[x] = t.dist[e.v] + e.w; t.par[x] = e.v; }
+            if(t.dist[x] < INF) pq.push({t.dist[x], x});
+        }
+        settle(t);
+        return nodes.size();
+    }
+    long long update(int u, int v, double oldW, double newW){
+        long long touched = 0;
+        if(u == v || oldW == newW) return 0;
+        for(auto &t: trees) touched += newW < oldW ? decrease(t, u, v, newW) : increase(t, u, v);
+        return touched;
+    }
+};
+
+struct BatchExecutor {
+    Graph &g;
+    int threads;
+    vector<Workspace> ws;
+    size_t chunk = 1<<22;
+    BatchExecutor(Graph &g, int threads): g(g), threads(max(1,threads)), ws(this->threads) {}
+    struct Stats { long long pairs = 0, sources = 0, bad = 0; double ms = 0; };
+    static bool parse_pair(const string &line, int &s, int &t){
+        size_t c = line.find(',');
+        if(c == string::npos) return false;
+        char *e1, *e2;
+        long a = strtol(line.c_str(), &e1, 10), b = strtol(line.c_str()+c+1, &e2, 10);
+        if(e1 != line.c_str()+c || e2 == line.c_str()+c+1) return false;
+        s = (int)a; t = (int)b; return true;
+    }
+    void solve(const vector<pair<int,int>> &q, vector<double> &out, QueueKind kind, Stats &st){
+        vector<int> idx(q.size());
+        iota(idx.begin(), idx.end(), 0);
+        stable_sort(idx.begin(), idx.end(), [&](int a, int b){ return q[a].first < q[b].first; });
+        vector<pair<size_t,size_t>> groups;
+        for(size_t i=0;i<idx.size();){
+            size_t j = i;
+            while(j < idx.size() && q[idx[j]].first == q[idx[i]].first) ++j;
+            int s = q[idx[i]].first;
+            if(s < 0 || s >= g.n){ for(size_t k=i;k<j;++k) out[idx[k]] = NAN; }
+            else groups.push_back({i, j});
+            i = j;
+        }
+        st.sources += groups.size();
+        atomic<size_t> next{0};
+        auto worker = [&](int tid){
+            Workspace &w = ws[tid];
+            vector<int> targets;
+            for(size_t gi; (gi = next.fetch_add(1)) < groups.size(); ){
+                auto [b, e] = groups[gi];
+                targets.clear();
+                for(size_t k=b;k<e;++k) targets.push_back(q[idx[k]].second);
+                g.search(w, q[idx[b]].first, targets, kind);
+                for(size_t k=b;k<e;++k){ int t = q[idx[k]].second; out[idx[k]] = (t<0||t>=g.n) ? NAN : w.get(t); }
+            }
+        };
+        vector<thread> pool;
+        for(int i=1;i<threads;++i) pool.emplace_back(worker, i);
+        worker(0);
+        for(auto &th: pool) th.join();
+    }
+    bool run(const string &inFile, const string &outFile, QueueKind kind, Stats &st){
+        ifstream in(inFile);
+        ofstream out(outFile);
+        if(!in.is_open() || !out.is_open()) return false;
+        auto t0 = chrono::steady_clock::now();
+        out<<"s,t,dist\n";
+        vector<pair<int,int>> q; vector<double> res;
+        auto flush = [&]{
+            res.assign(q.size(), 0);
+            solve(q, res, kind, st);
+            for(size_t i=0;i<q.size();++i){
+                out<<q[i].first<<','<<q[i].second<<',';
+                if(std::isnan(res[i])){ out<<"invalid\n"; ++st.bad; }
+                else if(res[i] > 1e17) out<<"inf\n";
+                else out<<res[i]<<'\n';
+            }
+            st.pairs += q.size();
+            q.clear();
+        };
+        string line; int s, t;
+        while(getline(in, line)){
+            if(!parse_pair(line, s, t)) continue;
+            q.push_back({s, t});
+            if(q.size() >= chunk) flush();
+        }
+        if(!q.empty()) flush();
+        st.ms = chrono::duration<double,milli>(chrono::steady_clock::now()-t0).count();
+        return (bool)out;
+    }
+};
+
 static vector<long long> load_points(const string &path, int &nmax){
     ifstream in(path);
     vector<long long> out; nmax=-1;
@@ -66,7 +616,7 @@ static vector<long long> load_points(const string &path, int &nmax){
 int main(int argc,char**argv){
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
-    if(argc<2){ cerr<<"Usage: "<<argv[0]<<" <csv>\n"; return 1; }
+    if(argc<2){ cerr<<"Usage: "<<argv[0]<<" <csv> [hierarchy.ch]\n"; return 1; }
     auto raw = load_edges_generic(argv[1]);
     if(raw.empty()){ cerr<<"no edges\n"; return 1; }
     int maxn=0;
@@ -74,7 +624,19 @@ int main(int argc,char**argv){
     Graph g(maxn+1);
     for(auto &t: raw){ int u,v; double w; tie(u,v,w)=t; g.add_edge(u,v,w); }
     cout<<"Graph nodes="<<g.n<<"\n";
-    cout<<"Commands:\nshortest s t\nmulti s id1 id2 id3 ...\ninspect-tour start k\nexit\n";
+    Workspace ws;
+    QueueKind queue = g.usable(QueueKind::Dial);
+    ContractionHierarchy ch;
+    TourPlanner planner(g);
+    DynamicSSSP dyn(g);
+    if(argc>2){
+        string chFile = argv[2];
+        auto t0 = chrono::steady_clock::now();
+        if(ch.load(chFile, g)) cout<<"ch loaded "<<chFile;
+        else { ch.build(g); ch.save(chFile); cout<<"ch built "<<chFile; }
+        cout<<" arcs="<<ch.up.size()<<" in "<<chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count()<<" ms\n";
+    }
+    cout<<"Commands:\nshortest s t\nmulti s id1 id2 id3 ...\ninspect-tour start k\nch build|save file|load file|off\nupdate u v w\nhot\nqueue heap|dial|radix\nbatch pairs.csv out.csv [threads]\nbench [sources] [targets]\nexit\n";
     string line;
     while(true){
         cout<<"> ";
@@ -85,11 +647,26 @@ int main(int argc,char**argv){
         if(cmd=="shortest"){
             int s,t; ss>>s>>t;
             if(s<0||s>=g.n||t<0||t>=g.n){ cout<<"invalid\n"; continue; }
-            auto pr = g.dijkstra(s);
-            auto &dist = pr.first; auto &par = pr.second;
-            if(dist[t] > 1e17) { cout<<"unreachable\n"; continue; }
-            auto path = g.reconstruct(par, t);
-            cout<<"cost="<<dist[t]<<" path:";
+            if(ch.ready()){
+                vector<int> path;
+                double d = ch.query(s, t, &path);
+                if(d > 1e17) { cout<<"unreachable\n"; continue; }
+                cout<<"cost="<<d<<" path:";
+                for(auto x:path) cout<<" "<<x;
+                cout<<"\n";
+                continue;
+            }
+            if(auto *tree = dyn.touch(s, ws, queue)){
+                if(tree->dist[t] > 1e17) { cout<<"unreachable\n"; continue; }
+                cout<<"cost="<<tree->dist[t]<<" path:";
+                for(auto x:dyn.path(*tree, t)) cout<<" "<<x;
+                cout<<"\n";
+                continue;
+            }
+            g.search(ws, s, {t}, queue);
+            if(ws.get(t) > 1e17) { cout<<"unreachable\n"; continue; }
+            auto path = g.path_to(ws, t);
+            cout<<"cost="<<ws.get(t)<<" path:";
             for(auto x:path) cout<<" "<<x;
             cout<<"\n";
             continue;
@@ -99,36 +676,99 @@ int main(int argc,char**argv){
             vector<int> targets; int x;
             while(ss>>x) targets.push_back(x);
             if(s<0||s>=g.n){ cout<<"invalid\n"; continue; }
-            auto pr = g.dijkstra(s);
-            auto &dist = pr.first;
+            if(auto *tree = dyn.touch(s, ws, queue)){
+                for(auto t: targets){
+                    if(t<0||t>=g.n) cout<<t<<":invalid\n"; else if(tree->dist[t]>1e17) cout<<t<<":unreach\n"; else cout<<t<<":"<<tree->dist[t]<<"\n";
+                }
+                continue;
+            }
+            g.search(ws, s, targets, queue);
             for(auto t: targets){
-                if(t<0||t>=g.n) cout<<t<<":invalid\n"; else if(dist[t]>1e17) cout<<t<<":unreach\n"; else cout<<t<<":"<<dist[t]<<"\n";
+                if(t<0||t>=g.n) cout<<t<<":invalid\n"; else if(ws.get(t)>1e17) cout<<t<<":unreach\n"; else cout<<t<<":"<<ws.get(t)<<"\n";
+            }
+            continue;
+        }
+        if(cmd=="update"){
+            int u,v; double w;
+            if(!(ss>>u>>v>>w) || u<0||u>=g.n||v<0||v>=g.n||u==v||w<0){ cout<<"invalid\n"; continue; }
+            auto t0 = chrono::steady_clock::now();
+            double old = g.set_weight(u, v, w);
+            long long touched = dyn.update(u, v, old, w);
+            planner.clear();
+            if(ch.ready()){ ch = ContractionHierarchy(); cout<<"ch dropped (graph changed)\n"; }
+            cout<<"updated "<<u<<"-"<<v<<" ";
+            if(old > 1e17) cout<<"none"; else cout<<old;
+            cout<<" -> "<<w<<" trees="<<dyn.trees.size()<<" touched="<<touched<<" in "<<chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now()-t0).count()<<" us\n";
+            continue;
+        }
+        if(cmd=="hot"){
+            cout<<"trees="<<dyn.trees.size()<<"/"<<dyn.capacity<<":";
+            for(auto &t: dyn.trees) cout<<" "<<t.src;
+            cout<<"\n";
+            continue;
+        }
+        if(cmd=="batch"){
+            string inFile, outFile; int threads = thread::hardware_concurrency(); ss>>inFile>>outFile>>threads;
+            if(inFile.empty() || outFile.empty()){ cout<<"batch pairs.csv out.csv [threads]\n"; continue; }
+            BatchExecutor exec(g, threads);
+            BatchExecutor::Stats st;
+            if(!exec.run(inFile, outFile, queue, st)){ cout<<"batch failed\n"; continue; }
+            cout<<"pairs="<<st.pairs<<" sources="<<st.sources<<" invalid="<<st.bad<<" threads="<<exec.threads<<" in "<<(long long)st.ms<<" ms ("<<(long long)(st.pairs/max(st.ms,1e-3)*1000)<<" queries/sec)\n";
+            continue;
+        }
+        if(cmd=="queue"){
+            string q; ss>>q;
+            QueueKind want = q=="dial" ? QueueKind::Dial : q=="radix" ? QueueKind::Radix : QueueKind::Heap;
+            if(q!="heap" && q!="dial" && q!="radix"){ cout<<"queue="<<queue_name(queue)<<"\n"; continue; }
+            queue = g.usable(want);
+            if(queue != want) cout<<"weights not small non-negative integers, using "<<queue_name(queue)<<"\n";
+            else cout<<"queue="<<queue_name(queue)<<"\n";
+            continue;
+        }
+        if(cmd=="bench"){
+            int sources=200, k=4; ss>>sources>>k;
+            if(sources<=0) sources=200;
+            if(k<0) k=0;
+            mt19937 rng(7);
+            vector<int> src(sources);
+            vector<vector<int>> tg(sources);
+            for(int i=0;i<sources;++i){ src[i] = rng()%g.n; for(int j=0;j<k;++j) tg[i].push_back(rng()%g.n); }
+            auto timed = [&](auto &&fn){ auto t0=chrono::steady_clock::now(); double sum = fn(); return make_pair(chrono::duration<double,milli>(chrono::steady_clock::now()-t0).count(), sum); };
+            auto base = timed([&]{ double sum=0; for(int i=0;i<sources;++i){ auto d = g.dijkstra(src[i]).first; for(int t: tg[i]) if(d[t]<1e17) sum += d[t]; } return sum; });
+            cout<<"variant        full_ms  multi_ms  settled/query  checksum\n";
+            cout<<"alloc-heap   "<<setw(9)<<fixed<<setprecision(2)<<base.first<<setw(10)<<"-"<<setw(15)<<g.n<<"  "<<setprecision(0)<<base.second<<"\n";
+            for(QueueKind q: {QueueKind::Heap, QueueKind::Dial, QueueKind::Radix}){
+                if(g.usable(q) != q){ cout<<queue_name(q)<<" skipped (non-integer weights)\n"; continue; }
+                auto full = timed([&]{ double sum=0; for(int i=0;i<sources;++i){ g.search(ws, src[i], {}, q); for(int t: tg[i]) if(ws.get(t)<1e17) sum += ws.get(t); } return sum; });
+                long long settled = 0;
+                auto early = timed([&]{ double sum=0; for(int i=0;i<sources;++i){ settled += g.search(ws, src[i], tg[i], q); for(int t: tg[i]) if(ws.get(t)<1e17) sum += ws.get(t); } return sum; });
+                bool ok = full.second == base.second && early.second == base.second;
+                cout<<left<<setw(13)<<queue_name(q)<<right<<setw(9)<<setprecision(2)<<full.first<<setw(10)<<early.first<<setw(15)<<setprecision(1)<<(double)settled/sources<<"  "<<setprecision(0)<<early.second<<(ok?"":" MISMATCH")<<"\n";
             }
+            cout.unsetf(ios::floatfield); cout<<setprecision(6);
+            continue;
+        }
+        if(cmd=="ch"){
+            string sub, file; ss>>sub>>file;
+            auto t0 = chrono::steady_clock::now();
+            if(sub=="build") ch.build(g);
+            else if(sub=="save"){ if(!ch.ready() || !ch.save(file)){ cout<<"save failed\n"; continue; } }
+            else if(sub=="load"){ if(!ch.load(file, g)){ cout<<"load failed\n"; continue; } }
+            else if(sub=="off"){ ch = ContractionHierarchy(); cout<<"ch off\n"; continue; }
+            else { cout<<"ch build|save file|load file|off\n"; continue; }
+            cout<<"ch "<<sub<<" arcs="<<ch.up.size()<<" in "<<chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count()<<" ms\n";
             continue;
         }
         if(cmd=="inspect-tour"){
             int start,k; ss>>start>>k;
             if(start<0||start>=g.n){ cout<<"invalid\n"; continue; }
-            vector<int> remaining;
-            for(int i=0;i<g.n;++i) remaining.push_back(i);
-            vector<int> tour; tour.push_back(start);
-            int cur = start;
-            for(int step=0; step<k && !remaining.empty(); ++step){
-                auto pr = g.dijkstra(cur);
-                auto &dist = pr.first;
-                int best=-1; double bestd=1e18;
-                for(auto node: remaining){
-                    if(node==cur) continue;
-                    if(dist[node] < bestd){ bestd = dist[node]; best = node; }
-                }
-                if(best==-1) break;
-                tour.push_back(best);
-                remaining.erase(find(remaining.begin(), remaining.end(), best));
-                cur = best;
-            }
+            auto t0 = chrono::steady_clock::now();
+            long long before = planner.computed;
+            auto res = planner.plan(start, k, queue);
             cout<<"tour:";
-            for(auto v:tour) cout<<" "<<v;
+            for(auto v:res.tour) cout<<" "<<v;
             cout<<"\n";
+            cout<<"length="<<res.length<<" greedy="<<res.greedy<<" moves="<<res.moves<<" rows="<<planner.computed-before<<"/"<<planner.rows.size()<<" in "<<chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now()-t0).count()<<" ms\n";
             continue;
         }
         cout<<"unknown\n";
@@ -1,83 +1,379 @@
 #include <bits/stdc++.h>
 using namespace std;
 
-struct PriceRow { string date; int product_id; double price; };
+struct MarketTable {
+    string keyName, timeName;
+    int keyCol = -1, timeCol = 0;
+    size_t width = 0;
+    vector<int> numericCols;
+    streamoff offset = 0;
+    bool unterminated = false;
+    vector<string> columns;
+    vector<string> keys;
+    vector<string> times;
+    vector<vector<double>> values;
+};
+
+static bool parse_num(const string &s, double &out){
+    if(s.empty()) return false;
+    char *end; out = strtod(s.c_str(), &end);
+    return *end=='\0';
+}
+
+static vector<string> split_csv(const string &line){
+    vector<string> cols; string cur; bool inq=false;
+    for (char c:line) {
+        if (c=='"') { inq=!inq; continue; }
+        if (c==',' && !inq) { cols.push_back(cur); cur.clear(); } else cur.push_back(c);
+    }
+    if(!cur.empty() && cur.back()=='\r') cur.pop_back();
+    cols.push_back(cur);
+    return cols;
+}
 
-static vector<PriceRow> load_csv(const string &path) {
+static MarketTable load_csv(const string &path, bool follow) {
     ifstream in(path);
-    vector<PriceRow> out;
-    if (!in.is_open()) return out;
+    MarketTable t;
+    if (!in.is_open()) return t;
     string line;
-    if (!getline(in, line)) return out;
+    if (!getline(in, line)) return t;
+    auto header = split_csv(line);
+    t.offset = in.tellg();
+    vector<vector<string>> raw;
     while (getline(in, line)) {
-        vector<string> cols; string cur; bool inq=false;
-        for (char c:line) {
-            if (c=='"') { inq=!inq; continue; }
-            if (c==',' && !inq) { cols.push_back(cur); cur.clear(); } else cur.push_back(c);
-        }
-        cols.push_back(cur);
-        if (cols.size() < 3) continue;
-        PriceRow r; r.date = cols[0]; r.product_id = stoi(cols[1]); r.price = stod(cols[2]);
-        out.push_back(r);
+        if(in.eof()){
+            if(follow) break;
+            t.offset += line.size(); t.unterminated = true;
+        } else t.offset = in.tellg();
+        if(line.empty()) continue;
+        auto cols = split_csv(line);
+        if (cols.size() != header.size()) continue;
+        raw.push_back(move(cols));
+    }
+    if(raw.empty()) return t;
+    int keyCol=-1, timeCol=-1;
+    for(int i=0;i<(int)header.size();++i){
+        if(header[i]=="category" || header[i]=="product_id") keyCol=i;
+        if(header[i]=="time" || header[i]=="date") timeCol=i;
     }
-    return out;
+    if(timeCol<0) timeCol=0;
+    vector<int> numeric;
+    for(int i=0;i<(int)header.size();++i){
+        double x;
+        if(i==timeCol || i==keyCol) continue;
+        if(parse_num(raw[0][i], x)) numeric.push_back(i);
+        else if(keyCol<0) keyCol=i;
+    }
+    t.keyCol = keyCol; t.timeCol = timeCol;
+    t.width = header.size();
+    t.numericCols = numeric;
+    t.keyName = keyCol>=0 ? header[keyCol] : "all";
+    t.timeName = header[timeCol];
+    for(int c: numeric) t.columns.push_back(header[c]);
+    t.values.assign(numeric.size(), {});
+    for(auto &cols: raw){
+        vector<double> row(numeric.size());
+        bool ok=true;
+        for(size_t j=0;j<numeric.size() && ok;++j) ok = parse_num(cols[numeric[j]], row[j]);
+        if(!ok) continue;
+        t.keys.push_back(keyCol>=0 ? cols[keyCol] : "all");
+        t.times.push_back(cols[timeCol]);
+        for(size_t j=0;j<numeric.size();++j) t.values[j].push_back(row[j]);
+    }
+    return t;
 }
 
 struct Fenwick {
     int n; vector<double> bit;
     Fenwick(): n(0) {}
     Fenwick(int n_): n(n_), bit(n_+1, 0.0) {}
+    void append(double x){
+        if(bit.empty()) bit.push_back(0.0);
+        if(bit.size()==bit.capacity()) bit.reserve(bit.size()*2);
+        int i = n+1;
+        auto pre = [&](int k){ double s=0; for(;k>0;k-=k&-k) s+=bit[k]; return s; };
+        bit.push_back(x + pre(i-1) - pre(i-(i&-i)));
+        n = i;
+    }
+    void build(const vector<double> &a){
+        n = a.size(); bit.assign(n+1, 0.0);
+        for(int i=1;i<=n;++i){ bit[i]+=a[i-1]; int j=i+(i&-i); if(j<=n) bit[j]+=bit[i]; }
+    }
     void add(int i, double delta){ for(++i;i<=n;i+=i&-i) bit[i]+=delta; }
     double sum(int i){ double s=0; for(++i;i>0;i-=i&-i) s+=bit[i]; return s; }
     double range(int l,int r){ if(l>r) return 0.0; return sum(r) - (l?sum(l-1):0.0); }
 };
 
 struct SegmentTree {
-    int n; vector<double> seg;
-    SegmentTree(): n(0) {}
-    SegmentTree(int n_): n(n_), seg(4*n_, numeric_limits<double>::infinity()) {}
-    void build(const vector<double> &a){ build_r(1,0,n-1,a); }
-    void build_r(int p,int l,int r,const vector<double>&a){
-        if(l==r){ seg[p]=a[l]; return; }
-        int m=(l+r)/2; build_r(p<<1,l,m,a); build_r(p<<1|1,m+1,r,a);
-        seg[p]=min(seg[p<<1], seg[p<<1|1]);
-    }
-    double query_min(int L,int R){ return query_r(1,0,n-1,L,R); }
-    double query_r(int p,int l,int r,int L,int R){
-        if(R<l||r<L) return numeric_limits<double>::infinity();
-        if(L<=l&&r<=R) return seg[p];
-        int m=(l+r)/2; return min(query_r(p<<1,l,m,L,R), query_r(p<<1|1,m+1,r,L,R));
+    int n, cap; vector<double> seg;
+    SegmentTree(): n(0), cap(1), seg(2, numeric_limits<double>::infinity()) {}
+    SegmentTree(int n_): n(0), cap(1) { while(cap<n_) cap<<=1; seg.assign(2*cap, numeric_limits<double>::infinity()); }
+    void build(const vector<double> &a){
+        n = a.size();
+        while(cap<n) cap<<=1;
+        seg.assign(2*cap, numeric_limits<double>::infinity());
+        copy(a.begin(), a.end(), seg.begin()+cap);
+        for(int p=cap-1;p>0;--p) seg[p]=min(seg[p<<1], seg[p<<1|1]);
+    }
+    void append(double x){
+        if(n==cap){ vector<double> leaves(seg.begin()+cap, seg.begin()+cap+n); cap<<=1; build(leaves); }
+        int p = cap + n++;
+        seg[p] = x;
+        for(p>>=1; p>0; p>>=1) seg[p]=min(seg[p<<1], seg[p<<1|1]);
+    }
+    double query_min(int L,int R) const {
+        double res = numeric_limits<double>::infinity();
+        for(int l=L+cap, r=R+cap+1; l<r; l>>=1, r>>=1){
+            if(l&1) res=min(res, seg[l++]);
+            if(r&1) res=min(res, seg[--r]);
+        }
+        return res;
+    }
+};
+
+struct WaveletMatrix {
+    struct Bits {
+        vector<uint64_t> w; vector<int> cum;
+        void init(int n){ w.assign(n/64+1, 0); cum.assign(n/64+2, 0); }
+        void set(int i){ w[i>>6] |= 1ULL<<(i&63); }
+        void seal(){ for(size_t i=0;i<w.size();++i) cum[i+1] = cum[i] + __builtin_popcountll(w[i]); }
+        int rank1(int i) const { return cum[i>>6] + __builtin_popcountll(w[i>>6] & ((1ULL<<(i&63))-1)); }
+        int rank0(int i) const { return i - rank1(i); }
+    };
+    int n = 0, levels = 0;
+    vector<double> values;
+    vector<Bits> bits;
+    vector<int> zeros;
+    void build(const vector<double> &a){
+        n = a.size();
+        values = a;
+        sort(values.begin(), values.end());
+        values.erase(unique(values.begin(), values.end()), values.end());
+        vector<int> code(n);
+        for(int i=0;i<n;++i) code[i] = lower_bound(values.begin(), values.end(), a[i]) - values.begin();
+        levels = 1;
+        while((1<<levels) < (int)values.size()) ++levels;
+        bits.assign(levels, Bits()); zeros.assign(levels, 0);
+        vector<int> next(n);
+        for(int lv=0;lv<levels;++lv){
+            int b = levels-1-lv;
+            bits[lv].init(n);
+            int z = 0;
+            for(int i=0;i<n;++i) if(code[i]>>b & 1) bits[lv].set(i); else ++z;
+            bits[lv].seal();
+            zeros[lv] = z;
+            int zi = 0, oi = z;
+            for(int i=0;i<n;++i) next[(code[i]>>b & 1) ? oi++ : zi++] = code[i];
+            swap(code, next);
+        }
+    }
+    double kth(int l, int r, int k) const {
+        int c = 0; ++r;
+        for(int lv=0;lv<levels;++lv){
+            int l0 = bits[lv].rank0(l), r0 = bits[lv].rank0(r);
+            if(k < r0-l0){ l = l0; r = r0; }
+            else { k -= r0-l0; c |= 1<<(levels-1-lv); l = zeros[lv] + (l-l0); r = zeros[lv] + (r-r0); }
+        }
+        return values[c];
+    }
+    int count_less(int l, int r, double x) const {
+        int c = lower_bound(values.begin(), values.end(), x) - values.begin();
+        ++r;
+        if(c >= (1<<levels)) return r-l;
+        int cnt = 0;
+        for(int lv=0;lv<levels;++lv){
+            int l0 = bits[lv].rank0(l), r0 = bits[lv].rank0(r);
+            if(c>>(levels-1-lv) & 1){ cnt += r0-l0; l = zeros[lv] + (l-l0); r = zeros[lv] + (r-r0); }
+            else { l = l0; r = r0; }
+        }
+        return cnt;
+    }
+};
+
+struct RangeStats { int count; double mean, var, sd; };
+
+struct Series {
+    vector<string> time;
+    vector<vector<double>> cols;
+    vector<double> shift;
+    vector<Fenwick> sum, sq;
+    vector<SegmentTree> mins;
+    vector<WaveletMatrix> wave;
+    int size() const { return time.size(); }
+};
+
+struct ColumnStore {
+    mutable shared_mutex mu;
+    mutex waveMu;
+    string keyName;
+    vector<string> columns;
+    vector<char> indexed;
+    map<string, Series> series;
+    int column(const string &name) const {
+        for(int i=0;i<(int)columns.size();++i) if(columns[i]==name) return i;
+        return -1;
+    }
+    void build(const MarketTable &t, const vector<string> &indexNames){
+        keyName = t.keyName;
+        columns = t.columns;
+        indexed.assign(columns.size(), indexNames.empty());
+        for(auto &name: indexNames){ int c = column(name); if(c>=0) indexed[c]=1; }
+        map<string, vector<int>> rowsOf;
+        for(int i=0;i<(int)t.keys.size();++i) rowsOf[t.keys[i]].push_back(i);
+        auto before = [&](int a,int b){
+            double x,y;
+            if(parse_num(t.times[a], x) && parse_num(t.times[b], y)) return x<y;
+            return t.times[a] < t.times[b];
+        };
+        series.clear();
+        for(auto &kv: rowsOf){
+            auto &idx = kv.second;
+            stable_sort(idx.begin(), idx.end(), before);
+            Series &s = series[kv.first];
+            int m = idx.size();
+            for(int i: idx) s.time.push_back(t.times[i]);
+            s.cols.assign(columns.size(), vector<double>(m));
+            s.shift.assign(columns.size(), 0.0);
+            s.sum.resize(columns.size()); s.sq.resize(columns.size()); s.mins.resize(columns.size());
+            for(size_t c=0;c<columns.size();++c){
+                auto &col = s.cols[c];
+                for(int i=0;i<m;++i) col[i] = t.values[c][idx[i]];
+                if(!indexed[c]) continue;
+                double shift = 0; for(double x: col) shift += x; shift /= max(1,m);
+                vector<double> d(m), d2(m);
+                for(int i=0;i<m;++i){ d[i] = col[i]-shift; d2[i] = d[i]*d[i]; }
+                s.shift[c] = shift;
+                s.sum[c].build(d); s.sq[c].build(d2);
+                s.mins[c] = SegmentTree(m); s.mins[c].build(col);
+            }
+        }
+    }
+    void append(const string &key, const string &time, const vector<double> &row){
+        auto it = series.find(key);
+        if(it == series.end()){
+            Series s;
+            s.cols.assign(columns.size(), {});
+            s.shift.assign(columns.size(), 0.0);
+            for(size_t c=0;c<columns.size();++c) s.shift[c] = row[c];
+            s.sum.resize(columns.size()); s.sq.resize(columns.size()); s.mins.resize(columns.size());
+            it = series.emplace(key, move(s)).first;
+        }
+        Series &s = it->second;
+        s.time.push_back(time);
+        for(size_t c=0;c<columns.size();++c){
+            s.cols[c].push_back(row[c]);
+            if(!indexed[c]) continue;
+            double d = row[c] - s.shift[c];
+            s.sum[c].append(d); s.sq[c].append(d*d);
+            s.mins[c].append(row[c]);
+        }
+    }
+    void refresh_wavelets(const string &key){
+        auto it = series.find(key);
+        if(it == series.end()) return;
+        Series &s = it->second;
+        for(size_t c=0;c<s.wave.size();++c) if(s.wave[c].n && s.wave[c].n != s.size()) s.wave[c].build(s.cols[c]);
+    }
+    WaveletMatrix& wavelet(Series &s, int c){
+        lock_guard<mutex> lk(waveMu);
+        if(s.wave.size() != columns.size()) s.wave.resize(columns.size());
+        if(s.wave[c].n != s.size()) s.wave[c].build(s.cols[c]);
+        return s.wave[c];
+    }
+    RangeStats stats(Series &s, int c, int l, int r){
+        RangeStats st{r-l+1, 0, 0, 0};
+        double sum = s.sum[c].range(l,r), sq = s.sq[c].range(l,r);
+        double mean = sum / st.count;
+        st.mean = s.shift[c] + mean;
+        st.var = max(0.0, sq / st.count - mean*mean);
+        st.sd = sqrt(st.var);
+        return st;
+    }
+};
+
+struct Ingestor {
+    ColumnStore &store;
+    MarketTable layout;
+    string file;
+    int intervalMs = 200;
+    streamoff offset = 0;
+    map<string, streamoff> resume;
+    atomic<bool> running{false};
+    atomic<long long> rows{0}, batches{0}, skipped{0};
+    thread worker;
+    Ingestor(ColumnStore &s, const MarketTable &t): store(s) {
+        layout.keyCol = t.keyCol; layout.timeCol = t.timeCol; layout.width = t.width; layout.numericCols = t.numericCols;
+    }
+    ~Ingestor(){ stop(); }
+    void poll(){
+        ifstream in(file, ios::binary);
+        if(!in.is_open()) return;
+        in.seekg(0, ios::end);
+        streamoff size = in.tellg();
+        if(size < offset) offset = size;
+        if(size == offset) return;
+        string buf(size-offset, '\0');
+        in.seekg(offset);
+        in.read(&buf[0], buf.size());
+        size_t last = buf.rfind('\n');
+        if(last == string::npos) return;
+        vector<tuple<string,string,vector<double>>> batch;
+        size_t pos = 0;
+        while(pos <= last){
+            size_t nl = buf.find('\n', pos);
+            string line = buf.substr(pos, nl-pos);
+            pos = nl+1;
+            if(line.empty()) continue;
+            auto cols = split_csv(line);
+            vector<double> row(layout.numericCols.size());
+            bool ok = cols.size()==layout.width;
+            for(size_t j=0;j<row.size() && ok;++j) ok = parse_num(cols[layout.numericCols[j]], row[j]);
+            if(!ok){ ++skipped; continue; }
+            batch.emplace_back(layout.keyCol>=0 ? cols[layout.keyCol] : "all", cols[layout.timeCol], move(row));
+        }
+        offset += last+1;
+        if(batch.empty()) return;
+        unique_lock<shared_mutex> lk(store.mu);
+        set<string> touched;
+        for(auto &r: batch){ store.append(get<0>(r), get<1>(r), get<2>(r)); touched.insert(get<0>(r)); }
+        for(auto &k: touched) store.refresh_wavelets(k);
+        rows += batch.size(); ++batches;
+    }
+    streamoff start(const string &f, streamoff from, int interval){
+        stop();
+        if(!file.empty()) resume[file] = offset;
+        auto it = resume.find(f);
+        if(it != resume.end()) from = it->second;
+        file = f; offset = from; intervalMs = max(1, interval);
+        running = true;
+        worker = thread([this]{ while(running){ poll(); this_thread::sleep_for(chrono::milliseconds(intervalMs)); } });
+        return from;
+    }
+    void stop(){
+        running = false;
+        if(worker.joinable()) worker.join();
     }
 };
 
 int main(int argc,char**argv){
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
-    if(argc<2){ cerr<<"Usage: "<<argv[0]<<" <csv>\n"; return 1; }
-    auto rows = load_csv(argv[1]);
-    if(rows.empty()){ cerr<<"No data\n"; return 1; }
-    unordered_map<int, vector<pair<string,double>>> perprod;
-    for(auto &r:rows) perprod[r.product_id].push_back({r.date,r.price});
-    unordered_map<int, vector<double>> pricevec;
-    for(auto &kv:perprod){
-        auto &v = kv.second;
-        sort(v.begin(), v.end(), [](const pair<string,double>&a,const pair<string,double>&b){ return a.first < b.first; });
-        for(auto &p:v) pricevec[kv.first].push_back(p.second);
-    }
-    unordered_map<int, Fenwick> fenw;
-    unordered_map<int, SegmentTree> segt;
-    for(auto &kv:pricevec){
-        int pid = kv.first;
-        int m = kv.second.size();
-        Fenwick fw(m);
-        for(int i=0;i<m;++i) fw.add(i, kv.second[i]);
-        fenw[pid]=move(fw);
-        SegmentTree st(m);
-        st.build(kv.second);
-        segt[pid]=move(st);
-    }
-    cout<<"Built for "<<pricevec.size()<<" products\n";
-    cout<<"Commands:\nsummary\navg <pid> <l> <r>\nmin <pid> <l> <r>\nvolatility <pid> <l> <r>\nexit\n";
+    vector<string> args;
+    bool follow = false;
+    for(int i=1;i<argc;++i){ if(string(argv[i])=="--follow") follow = true; else args.push_back(argv[i]); }
+    if(args.empty()){ cerr<<"Usage: "<<argv[0]<<" <csv> [indexed,columns] [--follow]\n"; return 1; }
+    auto table = load_csv(args[0], follow);
+    if(table.keys.empty() || table.columns.empty()){ cerr<<"No data\n"; return 1; }
+    vector<string> indexNames;
+    if(args.size()>1){ stringstream cs(args[1]); string c; while(getline(cs, c, ',')) if(!c.empty()) indexNames.push_back(c); }
+    ColumnStore store;
+    store.build(table, indexNames);
+    string defCol = store.column("price")>=0 ? "price" : store.columns[0];
+    cout<<"Built for "<<store.series.size()<<" "<<store.keyName<<" series, columns:";
+    for(size_t c=0;c<store.columns.size();++c) cout<<" "<<store.columns[c]<<(store.indexed[c] ? "*" : "");
+    cout<<"\n";
+    Ingestor ingest(store, table);
+    cout<<"Commands:\nsummary\ningest start [file] [interval_ms] | stop | status\navg <key> <l> <r> [col]\nmedian <key> <l> <r> [col]\nquantile <key> <l> <r> <q> [col]\ncountbelow <key> <l> <r> <x> [col]\nbench quantile <key> [queries] [col]\nmin <key> <l> <r> [col]\nvolatility <key> <l> <r> [col]\nstats <key> <l> <r> [col]\nexit\n";
     string line;
     while(true){
         cout<<"> ";
@@ -85,39 +381,85 @@ int main(int argc,char**argv){
         if(line.empty()) continue;
         stringstream ss(line); string cmd; ss>>cmd;
         if(cmd=="exit"||cmd=="quit") break;
-        if(cmd=="summary"){
-            cout<<"ProductID,Records\n";
-            for(auto &kv:pricevec) cout<<kv.first<<","<<kv.second.size()<<"\n";
+        if(cmd=="ingest"){
+            string sub; ss>>sub;
+            if(sub=="start"){
+                string file; int interval=200;
+                if(!(ss>>file)) file = args[0];
+                ss>>interval;
+                streamoff from = ingest.start(file, file==args[0] ? table.offset : 0, interval);
+                cout<<"ingesting "<<file<<" from byte "<<from<<" every "<<max(1,interval)<<" ms\n";
+                if(file==args[0] && table.unterminated) cout<<"note: last line of "<<file<<" had no newline and was loaded as complete; run with --follow to tail it\n";
+            } else if(sub=="stop"){ ingest.stop(); cout<<"ingest stopped\n"; }
+            else cout<<"ingest "<<(ingest.running ? "running" : "stopped")<<" rows="<<ingest.rows<<" batches="<<ingest.batches<<" skipped="<<ingest.skipped<<"\n";
             continue;
         }
-        if(cmd=="avg"){
-            int pid,l,r; ss>>pid>>l>>r;
-            if(fenw.find(pid)==fenw.end()){ cout<<"no product\n"; continue; }
-            double s = fenw[pid].range(l,r);
-            double avg = s / (r-l+1);
-            cout<<"avg="<<avg<<"\n";
+        shared_lock<shared_mutex> lk(store.mu);
+        if(cmd=="summary"){
+            cout<<store.keyName<<",Records\n";
+            for(auto &kv:store.series) cout<<kv.first<<","<<kv.second.size()<<"\n";
             continue;
         }
-        if(cmd=="min"){
-            int pid,l,r; ss>>pid>>l>>r;
-            if(segt.find(pid)==segt.end()){ cout<<"no product\n"; continue; }
-            double m = segt[pid].query_min(l,r);
-            cout<<"min="<<m<<"\n";
+        if(cmd=="bench"){
+            string what, key, col; int queries=2000;
+            ss>>what>>key>>queries;
+            if(!(ss>>col)) col = defCol;
+            auto it = store.series.find(key);
+            int c = store.column(col);
+            if(what!="quantile" || it==store.series.end() || c<0 || !store.indexed[c]){ cout<<"bench quantile <key> [queries] [col]\n"; continue; }
+            Series &s = it->second;
+            int m = s.size();
+            mt19937 rng(11);
+            vector<array<int,3>> qs(max(1,queries));
+            for(auto &q: qs){ int a = rng()%m, b = rng()%m; if(a>b) swap(a,b); q = {a, b, (int)(rng()%(b-a+1))}; }
+            auto t0 = chrono::steady_clock::now();
+            WaveletMatrix wm;
+            wm.build(s.cols[c]);
+            auto t1 = chrono::steady_clock::now();
+            double sumW = 0, sumS = 0; long long cntW = 0, cntS = 0;
+            for(auto &q: qs){ sumW += wm.kth(q[0], q[1], q[2]); cntW += wm.count_less(q[0], q[1], s.cols[c][q[0]]); }
+            auto t2 = chrono::steady_clock::now();
+            vector<double> buf;
+            for(auto &q: qs){
+                buf.assign(s.cols[c].begin()+q[0], s.cols[c].begin()+q[1]+1);
+                nth_element(buf.begin(), buf.begin()+q[2], buf.end());
+                sumS += buf[q[2]];
+                double x = s.cols[c][q[0]];
+                cntS += count_if(s.cols[c].begin()+q[0], s.cols[c].begin()+q[1]+1, [&](double v){ return v < x; });
+            }
+            auto t3 = chrono::steady_clock::now();
+            auto ms = [](auto a, auto b){ return chrono::duration<double,milli>(b-a).count(); };
+            cout<<"n="<<m<<" queries="<<qs.size()<<" build="<<ms(t0,t1)<<"ms wavelet="<<ms(t1,t2)<<"ms scan="<<ms(t2,t3)<<"ms "<<(sumW==sumS && cntW==cntS ? "match" : "MISMATCH")<<"\n";
             continue;
         }
-        if(cmd=="volatility"){
-            int pid,l,r; ss>>pid>>l>>r;
-            if(pricevec.find(pid)==pricevec.end()){ cout<<"no product\n"; continue; }
-            auto &v = pricevec[pid];
-            if(l<0) l=0; if(r>= (int)v.size()) r=v.size()-1;
-            double mean=0; int cnt=0;
-            for(int i=l;i<=r;++i){ mean+=v[i]; ++cnt; }
-            mean/=cnt;
-            double var=0;
-            for(int i=l;i<=r;++i){ double d=v[i]-mean; var+=d*d; }
-            var/=cnt;
-            double sd = sqrt(var);
-            cout<<"stddev="<<sd<<"\n";
+        if(cmd=="avg" || cmd=="min" || cmd=="volatility" || cmd=="stats" || cmd=="median" || cmd=="quantile" || cmd=="countbelow"){
+            string key, col; int l=0, r=-1; double param=0;
+            ss>>key>>l>>r;
+            if((cmd=="quantile" || cmd=="countbelow") && !(ss>>param)){ cout<<cmd<<" <key> <l> <r> <"<<(cmd=="quantile" ? "q" : "x")<<"> [col]\n"; continue; }
+            if(!(ss>>col)) col = defCol;
+            auto it = store.series.find(key);
+            if(it==store.series.end()){ cout<<"no "<<store.keyName<<"\n"; continue; }
+            int c = store.column(col);
+            if(c<0){ cout<<"no column "<<col<<"\n"; continue; }
+            if(!store.indexed[c]){ cout<<"column "<<col<<" not indexed\n"; continue; }
+            Series &s = it->second;
+            if(l<0) l=0;
+            if(r>=s.size()) r=s.size()-1;
+            if(l>r){ cout<<"empty range\n"; continue; }
+            if(cmd=="min"){ cout<<"min="<<s.mins[c].query_min(l,r)<<"\n"; continue; }
+            if(cmd=="median" || cmd=="quantile"){
+                double q = cmd=="median" ? 0.5 : param;
+                if(q<0 || q>1){ cout<<"q must be in [0,1]\n"; continue; }
+                int cnt = r-l+1;
+                int k = cmd=="median" ? (cnt-1)/2 : min(cnt-1, max(0, (int)ceil(q*cnt)-1));
+                cout<<(cmd=="median" ? "median=" : "quantile=")<<store.wavelet(s, c).kth(l, r, k)<<"\n";
+                continue;
+            }
+            if(cmd=="countbelow"){ cout<<"count="<<store.wavelet(s, c).count_less(l, r, param)<<"\n"; continue; }
+            auto st = store.stats(s, c, l, r);
+            if(cmd=="avg") cout<<"avg="<<st.mean<<"\n";
+            else if(cmd=="volatility") cout<<"stddev="<<st.sd<<"\n";
+            else cout<<"count="<<st.count<<" mean="<<st.mean<<" var="<<st.var<<" stddev="<<st.sd<<" min="<<s.mins[c].query_min(l,r)<<"\n";
             continue;
         }
         cout<<"unknown\n";
@@ -1,4 +1,11 @@
 #include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
 using D = double;
@@ -50,49 +57,495 @@ struct Loader {
     }
 };
 
+template<class T, size_t A=64>
+struct AlignedAlloc {
+    using value_type = T;
+    template<class U> struct rebind { using other = AlignedAlloc<U,A>; };
+    AlignedAlloc() noexcept {}
+    template<class U> AlignedAlloc(const AlignedAlloc<U,A>&) noexcept {}
+    T* allocate(size_t cnt){ return static_cast<T*>(::operator new(cnt*sizeof(T), align_val_t(A))); }
+    void deallocate(T* p, size_t){ ::operator delete(p, align_val_t(A)); }
+    template<class U> bool operator==(const AlignedAlloc<U,A>&) const { return true; }
+    template<class U> bool operator!=(const AlignedAlloc<U,A>&) const { return false; }
+};
+
+struct ThreadPool {
+    vector<thread> workers;
+    mutex mu;
+    condition_variable cv, done_cv;
+    function<void(int)> job;
+    atomic<int> cursor{0};
+    int total = 0, pending = 0;
+    long long gen = 0;
+    bool stop = false;
+    ThreadPool(int threads=0){
+        if(threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        for(int t=1;t<threads;++t) workers.emplace_back([this](){ worker(); });
+    }
+    ~ThreadPool(){
+        { lock_guard<mutex> lk(mu); stop = true; }
+        cv.notify_all();
+        for(auto &w: workers) w.join();
+    }
+    int size() const { return (int)workers.size() + 1; }
+    void drain(){
+        int i;
+        while((i = cursor.fetch_add(1)) < total) job(i);
+    }
+    void worker(){
+        long long seen = 0;
+        while(true){
+            {
+                unique_lock<mutex> lk(mu);
+                cv.wait(lk, [&](){ return stop || gen != seen; });
+                if(stop) return;
+                seen = gen;
+            }
+            drain();
+            { lock_guard<mutex> lk(mu); if(--pending == 0) done_cv.notify_one(); }
+        }
+    }
+    void parallel_for(int cnt, function<void(int)> f){
+        if(cnt <= 0) return;
+        if(workers.empty() || cnt == 1){ for(int i=0;i<cnt;++i) f(i); return; }
+        {
+            lock_guard<mutex> lk(mu);
+            job = move(f); total = cnt; cursor = 0;
+            pending = (int)workers.size(); ++gen;
+        }
+        cv.notify_all();
+        drain();
+        unique_lock<mutex> lk(mu);
+        done_cv.wait(lk, [&](){ return pending == 0; });
+    }
+};
+
+struct MappedFile {
+    void *base;
+    size_t len;
+    MappedFile():base(nullptr),len(0){}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile(){ close(); }
+    bool open_ro(const string &path){
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size <= 0){ ::close(fd); return false; }
+        void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED) return false;
+        base = p; len = (size_t)st.st_size;
+        return true;
+    }
+    void close(){ if(base){ munmap(base, len); base = nullptr; len = 0; } }
+    const char* bytes() const { return static_cast<const char*>(base); }
+};
+
+enum class DistMode : uint32_t { F64 = 1, F32 = 2, FIX32 = 3 };
+
+static const char* dist_mode_name(DistMode m){
+    switch(m){ case DistMode::F32: return "f32"; case DistMode::FIX32: return "fixed"; default: return "f64"; }
+}
+
+static bool parse_dist_mode(const string &s, DistMode &m){
+    if(s=="f64"){ m = DistMode::F64; return true; }
+    if(s=="f32"){ m = DistMode::F32; return true; }
+    if(s=="fixed"){ m = DistMode::FIX32; return true; }
+    return false;
+}
+
+template<class T> struct Cell {
+    static T inf(){ return (T)INF; }
+    static T enc(D x, D){ return x >= INF ? inf() : (T)x; }
+    static D dec(T x, D){ return x >= inf() ? INF : (D)x; }
+    static T add(T a, T b){ return a + b; }
+    static D tie_eps(){ return sizeof(T) == sizeof(D) ? 1e-9 : 1e-5; }
+};
+
+template<> struct Cell<int32_t> {
+    static int32_t inf(){ return 0x3fffffff; }
+    static int32_t enc(D x, D scale){
+        if(x >= INF) return inf();
+        D s = x*scale;
+        if(s >= inf()) return inf();
+        if(s <= -inf()) return -inf();
+        return (int32_t)llround(s);
+    }
+    static D dec(int32_t x, D scale){ return x >= inf() ? INF : x/scale; }
+    static int32_t add(int32_t a, int32_t b){
+        int64_t s = (int64_t)a + b;
+        return s >= inf() ? inf() : s <= -inf() ? -inf() : (int32_t)s;
+    }
+    static D tie_eps(){ return 0; }
+};
+
+template<class H> struct Hop {
+    static H enc(int h){ return (H)h; }
+    static int dec(H h){ return (int)h; }
+};
+
+template<> struct Hop<uint16_t> {
+    static uint16_t enc(int h){ return h < 0 ? 0xFFFF : (uint16_t)h; }
+    static int dec(uint16_t h){ return h == 0xFFFF ? -1 : (int)h; }
+};
+
+struct MinPlus {
+#if defined(__AVX2__)
+    static const char* isa(){ return "avx2"; }
+    using Mask8 = __m256i;
+    static Mask8 relax8(const float *rk, float *ri, float dik){
+        __m256 r = _mm256_loadu_ps(rk);
+        __m256 nd = _mm256_add_ps(_mm256_set1_ps(dik), r);
+        __m256 cur = _mm256_loadu_ps(ri);
+        __m256 m = _mm256_and_ps(_mm256_cmp_ps(nd, cur, _CMP_LT_OQ), _mm256_cmp_ps(r, _mm256_set1_ps(Cell<float>::inf()), _CMP_LT_OQ));
+        _mm256_storeu_ps(ri, _mm256_blendv_ps(cur, nd, m));
+        return _mm256_castps_si256(m);
+    }
+    static Mask8 relax8(const int32_t *rk, int32_t *ri, int32_t dik){
+        __m256i r = _mm256_loadu_si256((const __m256i*)rk);
+        __m256i nd = _mm256_add_epi32(_mm256_set1_epi32(dik), r);
+        __m256i cur = _mm256_loadu_si256((const __m256i*)ri);
+        __m256i m = _mm256_and_si256(_mm256_cmpgt_epi32(cur, nd), _mm256_cmpgt_epi32(_mm256_set1_epi32(Cell<int32_t>::inf()), r));
+        _mm256_storeu_si256((__m256i*)ri, _mm256_blendv_epi8(cur, nd, m));
+        return m;
+    }
+    static Mask8 relax8(const D *rk, D *ri, D dik){
+        __m256d s = _mm256_set1_pd(dik), inf = _mm256_set1_pd(Cell<D>::inf());
+        __m256d r0 = _mm256_loadu_pd(rk), r1 = _mm256_loadu_pd(rk+4);
+        __m256d nd0 = _mm256_add_pd(s, r0), nd1 = _mm256_add_pd(s, r1);
+        __m256d c0 = _mm256_loadu_pd(ri), c1 = _mm256_loadu_pd(ri+4);
+        __m256d m0 = _mm256_and_pd(_mm256_cmp_pd(nd0, c0, _CMP_LT_OQ), _mm256_cmp_pd(r0, inf, _CMP_LT_OQ));
+        __m256d m1 = _mm256_and_pd(_mm256_cmp_pd(nd1, c1, _CMP_LT_OQ), _mm256_cmp_pd(r1, inf, _CMP_LT_OQ));
+        _mm256_storeu_pd(ri, _mm256_blendv_pd(c0, nd0, m0));
+        _mm256_storeu_pd(ri+4, _mm256_blendv_pd(c1, nd1, m1));
+        __m256i lo = _mm256_setr_epi32(0,2,4,6,0,2,4,6);
+        __m256i p0 = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(m0), lo);
+        __m256i p1 = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(m1), lo);
+        return _mm256_permute2x128_si256(p0, p1, 0x20);
+    }
+    static void blend8(int32_t *hi, int32_t hk, Mask8 m){
+        __m256i h = _mm256_loadu_si256((const __m256i*)hi);
+        _mm256_storeu_si256((__m256i*)hi, _mm256_blendv_epi8(h, _mm256_set1_epi32(hk), m));
+    }
+    static void blend8(uint16_t *hi, uint16_t hk, Mask8 m){
+        __m128i m16 = _mm_packs_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+        __m128i h = _mm_loadu_si128((const __m128i*)hi);
+        _mm_storeu_si128((__m128i*)hi, _mm_blendv_epi8(h, _mm_set1_epi16((short)hk), m16));
+    }
+#elif defined(__SSE4_1__)
+    static const char* isa(){ return "sse4.1"; }
+    struct Mask8 { __m128i lo, hi; };
+    static Mask8 relax8(const float *rk, float *ri, float dik){
+        __m128 s = _mm_set1_ps(dik), inf = _mm_set1_ps(Cell<float>::inf());
+        __m128 r0 = _mm_loadu_ps(rk), r1 = _mm_loadu_ps(rk+4);
+        __m128 nd0 = _mm_add_ps(s, r0), nd1 = _mm_add_ps(s, r1);
+        __m128 c0 = _mm_loadu_ps(ri), c1 = _mm_loadu_ps(ri+4);
+        __m128 m0 = _mm_and_ps(_mm_cmplt_ps(nd0, c0), _mm_cmplt_ps(r0, inf)), m1 = _mm_and_ps(_mm_cmplt_ps(nd1, c1), _mm_cmplt_ps(r1, inf));
+        _mm_storeu_ps(ri, _mm_blendv_ps(c0, nd0, m0));
+        _mm_storeu_ps(ri+4, _mm_blendv_ps(c1, nd1, m1));
+        return Mask8{ _mm_castps_si128(m0), _mm_castps_si128(m1) };
+    }
+    static Mask8 relax8(const int32_t *rk, int32_t *ri, int32_t dik){
+        __m128i s = _mm_set1_epi32(dik), inf = _mm_set1_epi32(Cell<int32_t>::inf());
+        __m128i r0 = _mm_loadu_si128((const __m128i*)rk), r1 = _mm_loadu_si128((const __m128i*)(rk+4));
+        __m128i nd0 = _mm_add_epi32(s, r0), nd1 = _mm_add_epi32(s, r1);
+        __m128i c0 = _mm_loadu_si128((const __m128i*)ri), c1 = _mm_loadu_si128((const __m128i*)(ri+4));
+        Mask8 m{ _mm_and_si128(_mm_cmpgt_epi32(c0, nd0), _mm_cmpgt_epi32(inf, r0)), _mm_and_si128(_mm_cmpgt_epi32(c1, nd1), _mm_cmpgt_epi32(inf, r1)) };
+        _mm_storeu_si128((__m128i*)ri, _mm_blendv_epi8(c0, nd0, m.lo));
+        _mm_storeu_si128((__m128i*)(ri+4), _mm_blendv_epi8(c1, nd1, m.hi));
+        return m;
+    }
+    static Mask8 relax8(const D *rk, D *ri, D dik){
+        __m128d s = _mm_set1_pd(dik), inf = _mm_set1_pd(Cell<D>::inf()), mm[4];
+        for(int q=0;q<4;++q){
+            __m128d r = _mm_loadu_pd(rk+2*q), nd = _mm_add_pd(s, r), c = _mm_loadu_pd(ri+2*q);
+            mm[q] = _mm_and_pd(_mm_cmplt_pd(nd, c), _mm_cmplt_pd(r, inf));
+            _mm_storeu_pd(ri+2*q, _mm_blendv_pd(c, nd, mm[q]));
+        }
+        auto pack = [](__m128d a, __m128d b){ return _mm_castps_si128(_mm_shuffle_ps(_mm_castpd_ps(a), _mm_castpd_ps(b), _MM_SHUFFLE(2,0,2,0))); };
+        return Mask8{ pack(mm[0], mm[1]), pack(mm[2], mm[3]) };
+    }
+    static void blend8(int32_t *hi, int32_t hk, Mask8 m){
+        __m128i v = _mm_set1_epi32(hk);
+        _mm_storeu_si128((__m128i*)hi, _mm_blendv_epi8(_mm_loadu_si128((const __m128i*)hi), v, m.lo));
+        _mm_storeu_si128((__m128i*)(hi+4), _mm_blendv_epi8(_mm_loadu_si128((const __m128i*)(hi+4)), v, m.hi));
+    }
+    static void blend8(uint16_t *hi, uint16_t hk, Mask8 m){
+        __m128i m16 = _mm_packs_epi32(m.lo, m.hi);
+        __m128i h = _mm_loadu_si128((const __m128i*)hi);
+        _mm_storeu_si128((__m128i*)hi, _mm_blendv_epi8(h, _mm_set1_epi16((short)hk), m16));
+    }
+#else
+    static const char* isa(){ return "scalar"; }
+#endif
+    template<class DT, class HT>
+    static void row(const DT *rk, DT *ri, HT *hi, DT dik, HT hk, int jb, int je){
+        int j = jb;
+#if defined(__AVX2__) || defined(__SSE4_1__)
+        for(; j+8<=je; j+=8) blend8(hi+j, hk, relax8(rk+j, ri+j, dik));
+#endif
+        for(; j<je; ++j){
+            if(rk[j] >= Cell<DT>::inf()) continue;
+            DT nd = dik + rk[j];
+            if(nd < ri[j]){ ri[j] = nd; hi[j] = hk; }
+        }
+    }
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    int64_t n;
+    int64_t ld;
+    int64_t m;
+    uint64_t checksum;
+    D scale;
+    char pad[8];
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay 64 bytes");
+
+struct SnapshotEdge { int32_t u; int32_t v; D w; };
+
+struct Snapshot {
+    static constexpr char MAGIC[8] = {'F','W','S','N','A','P','\0','\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t HOP16 = 0x10;
+    static uint32_t dtype_of(DistMode m, bool hop16){ return (uint32_t)m | (hop16 ? HOP16 : 0); }
+    static bool valid_dtype(uint32_t t){ uint32_t m = t & 0xF; return (t & ~(0xFu | HOP16)) == 0 && m >= 1 && m <= 3; }
+    static size_t dist_bytes(uint32_t t){ return (DistMode)(t & 0xF) == DistMode::F64 ? sizeof(D) : 4; }
+    static size_t hop_bytes(uint32_t t){ return (t & HOP16) ? 2 : 4; }
+    static uint64_t fnv1a(const char *p, size_t len, uint64_t h=1469598103934665603ULL){
+        for(size_t i=0;i<len;++i){ h ^= (unsigned char)p[i]; h *= 1099511628211ULL; }
+        return h;
+    }
+    static size_t dist_offset(){ return sizeof(SnapshotHeader); }
+    static size_t next_offset(const SnapshotHeader &h){ return dist_offset() + (((size_t)(h.n*h.ld)*dist_bytes(h.dtype) + 7) & ~(size_t)7); }
+    static size_t edge_offset(const SnapshotHeader &h){ return next_offset(h) + (((size_t)(h.n*h.ld)*hop_bytes(h.dtype) + 7) & ~(size_t)7); }
+    static size_t total_size(const SnapshotHeader &h){ return edge_offset(h) + (size_t)h.m*sizeof(SnapshotEdge); }
+    static bool is_snapshot(const string &path){
+        ifstream in(path, ios::binary);
+        char m[8] = {0};
+        in.read(m, 8);
+        return in.gcount() == 8 && memcmp(m, MAGIC, 8) == 0;
+    }
+};
+
 struct Floyd {
+    using Bytes = vector<unsigned char, AlignedAlloc<unsigned char>>;
     int n;
-    vector<vector<D>> dist;
-    vector<vector<int>> next;
-    Floyd():n(0){}
+    int ld;
+    int tile;
+    DistMode mode;
+    int hopBits;
+    bool hop16;
+    D scale;
+    D fixBound;
+    Bytes dist;
+    Bytes next;
+    const unsigned char *dv;
+    const unsigned char *nv;
+    MappedFile snap;
+    Floyd():n(0),ld(0),tile(64),mode(DistMode::F64),hopBits(32),hop16(false),scale(1000.0),fixBound(0),dv(nullptr),nv(nullptr){}
+    uint32_t dtype() const { return Snapshot::dtype_of(mode, hop16); }
+    size_t cells() const { return (size_t)n*ld; }
+    size_t bytes() const { return cells()*(Snapshot::dist_bytes(dtype()) + Snapshot::hop_bytes(dtype())); }
+    D at(int i,int j) const {
+        size_t p = (size_t)i*ld + j;
+        switch(mode){
+            case DistMode::F32: return Cell<float>::dec(((const float*)dv)[p], scale);
+            case DistMode::FIX32: return Cell<int32_t>::dec(((const int32_t*)dv)[p], scale);
+            default: return ((const D*)dv)[p];
+        }
+    }
+    int hop(int i,int j) const {
+        size_t p = (size_t)i*ld + j;
+        return hop16 ? Hop<uint16_t>::dec(((const uint16_t*)nv)[p]) : ((const int32_t*)nv)[p];
+    }
+    bool mapped() const { return snap.base != nullptr; }
+    template<class F> void visit(F &&f){
+        auto with_hops = [&](auto *dm){
+            if(hop16) f(dm, (uint16_t*)next.data()); else f(dm, (int32_t*)next.data());
+        };
+        switch(mode){
+            case DistMode::F32: with_hops((float*)dist.data()); break;
+            case DistMode::FIX32: with_hops((int32_t*)dist.data()); break;
+            default: with_hops((D*)dist.data()); break;
+        }
+    }
+    void configure(DistMode m, int bits){ mode = m; hopBits = bits; }
+    bool fit_scale(const vector<Edge> &edges, int nodes){
+        fixBound = 0;
+        if(mode != DistMode::FIX32) return true;
+        vector<D> mag;
+        for(auto &e: edges) if(e.u != e.v && e.w < INF) mag.push_back(fabs(e.w));
+        size_t k = min(mag.size(), (size_t)max(0, nodes-1));
+        partial_sort(mag.begin(), mag.begin()+k, mag.end(), greater<D>());
+        fixBound = accumulate(mag.begin(), mag.begin()+k, (D)0);
+        for(scale = 1000.0; scale >= 1 && fixBound*scale >= Cell<int32_t>::inf(); scale /= 10);
+        return scale >= 1;
+    }
+    bool absorb(D w){
+        if(mode != DistMode::FIX32) return true;
+        if((fixBound + fabs(w))*scale >= Cell<int32_t>::inf()) return false;
+        fixBound += fabs(w);
+        return true;
+    }
     void init(int n_){
+        snap.close();
         n = n_;
-        dist.assign(n, vector<D>(n, INF));
-        next.assign(n, vector<int>(n, -1));
-        for(int i=0;i<n;++i) dist[i][i]=0, next[i][i]=i;
+        ld = (n + 7) & ~7;
+        hop16 = hopBits != 32 && n < 0xFFFF && (hopBits == 16 || mode != DistMode::F64);
+        dist.assign(cells()*Snapshot::dist_bytes(dtype()), 0);
+        next.assign(cells()*Snapshot::hop_bytes(dtype()), 0);
+        visit([&](auto *dm, auto *hm){
+            using DT = remove_pointer_t<decltype(dm)>;
+            using HT = remove_pointer_t<decltype(hm)>;
+            fill(dm, dm + cells(), Cell<DT>::inf());
+            fill(hm, hm + cells(), Hop<HT>::enc(-1));
+            for(int i=0;i<n;++i) dm[(size_t)i*ld+i] = 0, hm[(size_t)i*ld+i] = Hop<HT>::enc(i);
+        });
+        dv = dist.data(); nv = next.data();
+    }
+    bool save_snapshot(const string &path, const vector<Edge> &edges) const {
+        SnapshotHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, Snapshot::MAGIC, 8);
+        h.version = Snapshot::VERSION;
+        h.dtype = dtype();
+        h.n = n; h.ld = ld; h.m = (int64_t)edges.size();
+        h.scale = scale;
+        size_t dbytes = cells()*Snapshot::dist_bytes(h.dtype), hbytes = cells()*Snapshot::hop_bytes(h.dtype);
+        vector<SnapshotEdge> es; es.reserve(edges.size());
+        for(auto &e: edges) es.push_back({e.u, e.v, e.w});
+        size_t distPad = Snapshot::next_offset(h) - Snapshot::dist_offset() - dbytes;
+        size_t nextPad = Snapshot::edge_offset(h) - Snapshot::next_offset(h) - hbytes;
+        const char zeros[8] = {0};
+        uint64_t c = Snapshot::fnv1a((const char*)dv, dbytes);
+        c = Snapshot::fnv1a(zeros, distPad, c);
+        c = Snapshot::fnv1a((const char*)nv, hbytes, c);
+        c = Snapshot::fnv1a(zeros, nextPad, c);
+        c = Snapshot::fnv1a((const char*)es.data(), es.size()*sizeof(SnapshotEdge), c);
+        h.checksum = c;
+        string tmp = path + ".tmp";
+        ofstream out(tmp, ios::binary | ios::trunc);
+        if(!out.is_open()) return false;
+        out.write((const char*)&h, sizeof(h));
+        out.write((const char*)dv, dbytes);
+        out.write(zeros, distPad);
+        out.write((const char*)nv, hbytes);
+        out.write(zeros, nextPad);
+        out.write((const char*)es.data(), es.size()*sizeof(SnapshotEdge));
+        out.close();
+        if(!out) return false;
+        return rename(tmp.c_str(), path.c_str()) == 0;
+    }
+    bool map_snapshot(const string &path, vector<Edge> &edges, string &err){
+        MappedFile mf;
+        if(!mf.open_ro(path)){ err = "cannot map " + path; return false; }
+        if(mf.len < sizeof(SnapshotHeader)){ err = "truncated header"; return false; }
+        SnapshotHeader h;
+        memcpy(&h, mf.bytes(), sizeof(h));
+        if(memcmp(h.magic, Snapshot::MAGIC, 8) != 0){ err = "bad magic"; return false; }
+        if(h.version != Snapshot::VERSION){ err = "unsupported version " + to_string(h.version); return false; }
+        if(!Snapshot::valid_dtype(h.dtype)){ err = "unsupported dtype " + to_string(h.dtype); return false; }
+        if(h.n < 0 || h.ld < h.n || h.m < 0 || mf.len != Snapshot::total_size(h)){ err = "size mismatch"; return false; }
+        dist.clear(); dist.shrink_to_fit();
+        next.clear(); next.shrink_to_fit();
+        n = (int)h.n; ld = (int)h.ld;
+        mode = (DistMode)(h.dtype & 0xF);
+        hop16 = (h.dtype & Snapshot::HOP16) != 0;
+        hopBits = hop16 ? 16 : 32;
+        if(mode == DistMode::FIX32) scale = h.scale;
+        dv = (const unsigned char*)mf.bytes() + Snapshot::dist_offset();
+        nv = (const unsigned char*)mf.bytes() + Snapshot::next_offset(h);
+        const SnapshotEdge *es = reinterpret_cast<const SnapshotEdge*>(mf.bytes() + Snapshot::edge_offset(h));
+        edges.clear(); edges.reserve(h.m);
+        for(int64_t i=0;i<h.m;++i) edges.emplace_back(es[i].u, es[i].v, es[i].w);
+        swap(snap.base, mf.base); swap(snap.len, mf.len);
+        return true;
+    }
+    bool verify_snapshot() const {
+        if(!mapped()) return false;
+        SnapshotHeader h;
+        memcpy(&h, snap.bytes(), sizeof(h));
+        return Snapshot::fnv1a(snap.bytes() + sizeof(h), snap.len - sizeof(h)) == h.checksum;
+    }
+    void thaw(){
+        if(!mapped()) return;
+        dist.assign(dv, dv + cells()*Snapshot::dist_bytes(dtype()));
+        next.assign(nv, nv + cells()*Snapshot::hop_bytes(dtype()));
+        snap.close();
+        dv = dist.data(); nv = next.data();
     }
     void load_edges(const vector<Edge> &edges){
-        for(auto &e: edges){
-            if(e.u>=0 && e.u<n && e.v>=0 && e.v<n){
-                if(e.w < dist[e.u][e.v]){
-                    dist[e.u][e.v] = e.w;
-                    next[e.u][e.v] = e.v;
+        visit([&](auto *dm, auto *hm){
+            using DT = remove_pointer_t<decltype(dm)>;
+            using HT = remove_pointer_t<decltype(hm)>;
+            for(auto &e: edges){
+                if(e.u>=0 && e.u<n && e.v>=0 && e.v<n){
+                    size_t p = (size_t)e.u*ld + e.v;
+                    DT w = Cell<DT>::enc(e.w, scale);
+                    if(w < dm[p]){
+                        dm[p] = w;
+                        hm[p] = Hop<HT>::enc(e.v);
+                    }
                 }
             }
-        }
+        });
     }
-    void compute(){
-        for(int k=0;k<n;++k){
-            for(int i=0;i<n;++i){
-                if(dist[i][k] >= INF) continue;
-                for(int j=0;j<n;++j){
-                    D nd = dist[i][k] + dist[k][j];
-                    if(nd < dist[i][j]){
-                        dist[i][j] = nd;
-                        next[i][j] = next[i][k];
-                    }
-                }
+    template<class DT, class HT>
+    void relax_tile(DT *dm, HT *nx, int kb,int ke,int ib,int ie,int jb,int je){
+        for(int k=kb;k<ke;++k){
+            const DT *rowk = dm + (size_t)k*ld;
+            for(int i=ib;i<ie;++i){
+                DT *rowi = dm + (size_t)i*ld;
+                DT dik = rowi[k];
+                if(dik >= Cell<DT>::inf()) continue;
+                HT *nxi = nx + (size_t)i*ld;
+                MinPlus::row(rowk, rowi, nxi, dik, nxi[k], jb, je);
             }
         }
     }
+    void compute(ThreadPool &pool){
+        visit([&](auto *dm, auto *hm){ compute_t(dm, hm, pool); });
+    }
+    template<class DT, class HT>
+    void compute_t(DT *dm, HT *hm, ThreadPool &pool){
+        int B = max(1, tile);
+        int nb = (n + B - 1) / B;
+        auto lo = [&](int b){ return b*B; };
+        auto hi = [&](int b){ return min(n, (b+1)*B); };
+        for(int b=0;b<nb;++b){
+            int kb = lo(b), ke = hi(b);
+            relax_tile(dm,hm, kb,ke, kb,ke, kb,ke);
+            pool.parallel_for(2*(nb-1), [&](int t){
+                int o = t % (nb-1); if(o >= b) ++o;
+                if(t < nb-1) relax_tile(dm,hm, kb,ke, kb,ke, lo(o),hi(o));
+                else relax_tile(dm,hm, kb,ke, lo(o),hi(o), kb,ke);
+            });
+            pool.parallel_for((nb-1)*(nb-1), [&](int t){
+                int bi = t / (nb-1), bj = t % (nb-1);
+                if(bi >= b) ++bi;
+                if(bj >= b) ++bj;
+                relax_tile(dm,hm, kb,ke, lo(bi),hi(bi), lo(bj),hi(bj));
+            });
+        }
+    }
+    void compute(){
+        ThreadPool pool;
+        compute(pool);
+    }
     vector<int> path(int u,int v){
         vector<int> out;
         if(u<0||v<0||u>=n||v>=n) return out;
-        if(next[u][v] == -1) return out;
+        if(hop(u,v) == -1) return out;
         int cur = u;
         out.push_back(cur);
         while(cur != v){
-            cur = next[cur][v];
+            cur = hop(cur,v);
             if(cur == -1) return {};
             out.push_back(cur);
         }
@@ -100,7 +553,7 @@ struct Floyd {
     }
     D allpairs_sum(){
         D s = 0;
-        for(int i=0;i<n;++i) for(int j=0;j<n;++j) if(dist[i][j] < INF) s += dist[i][j];
+        for(int i=0;i<n;++i) for(int j=0;j<n;++j) if(at(i,j) < INF) s += at(i,j);
         return s;
     }
     void export_matrix_csv(const string &path){
@@ -109,7 +562,7 @@ struct Floyd {
         for(int i=0;i<n;++i){
             for(int j=0;j<n;++j){
                 if(j) out<<",";
-                if(dist[i][j] >= INF/2) out<<"INF"; else out<<dist[i][j];
+                if(at(i,j) >= INF/2) out<<"INF"; else out<<at(i,j);
             }
             out<<"\n";
         }
@@ -118,84 +571,506 @@ struct Floyd {
     void export_next_csv(const string &path){
         ofstream out(path);
         out<<"u,v,next\n";
-        for(int i=0;i<n;++i) for(int j=0;j<n;++j) if(dist[i][j] < INF){
-            out<<i<<","<<j<<","<<next[i][j]<<"\n";
+        for(int i=0;i<n;++i) for(int j=0;j<n;++j) if(at(i,j) < INF){
+            out<<i<<","<<j<<","<<hop(i,j)<<"\n";
         }
         out.close();
     }
     vector<int> reachable_from(int u){
         vector<int> out;
         if(u<0||u>=n) return out;
-        for(int v=0;v<n;++v) if(dist[u][v] < INF && u!=v) out.push_back(v);
+        for(int v=0;v<n;++v) if(at(u,v) < INF && u!=v) out.push_back(v);
         return out;
     }
+    bool relax_through(int u,int v,D w){
+        if(at(v,u) < INF && at(v,u) + w < 0) return false;
+        visit([&](auto *dm, auto *hm){
+            using DT = remove_pointer_t<decltype(dm)>;
+            using HT = remove_pointer_t<decltype(hm)>;
+            DT ew = Cell<DT>::enc(w, scale), inf = Cell<DT>::inf();
+            const DT *rowv = dm + (size_t)v*ld;
+            for(int i=0;i<n;++i){
+                DT diu = (i==u) ? 0 : dm[(size_t)i*ld + u];
+                if(diu >= inf) continue;
+                DT base = Cell<DT>::add(diu, ew);
+                HT h = (i==u) ? Hop<HT>::enc(v) : hm[(size_t)i*ld + u];
+                DT *rowi = dm + (size_t)i*ld;
+                HT *nxi = hm + (size_t)i*ld;
+                for(int j=0;j<n;++j){
+                    if(rowv[j] >= inf) continue;
+                    DT nd = Cell<DT>::add(base, rowv[j]);
+                    if(nd < rowi[j]){ rowi[j] = nd; nxi[j] = h; }
+                }
+            }
+        });
+        return true;
+    }
+    void repair_increase(int u,int v,D oldw,const vector<vector<D>> &w,const vector<vector<int>> &preds,ThreadPool &pool){
+        visit([&](auto *dm, auto *hm){
+            using DT = remove_pointer_t<decltype(dm)>;
+            using HT = remove_pointer_t<decltype(hm)>;
+            const DT inf = Cell<DT>::inf(), ow = Cell<DT>::enc(oldw, scale);
+            auto tied = [](DT a,DT b){ return fabs((D)a-(D)b) <= Cell<DT>::tie_eps()*max((D)1, fabs((D)b)); };
+            auto ew = [&](int x,int j){ return Cell<DT>::enc(w[x][j], scale); };
+            vector<DT> rowv(dm + (size_t)v*ld, dm + (size_t)v*ld + n);
+            vector<int> sources;
+            for(int i=0;i<n;++i){
+                DT diu = dm[(size_t)i*ld + u];
+                if(diu < inf && tied(Cell<DT>::add(diu, ow), dm[(size_t)i*ld + v])) sources.push_back(i);
+            }
+            pool.parallel_for((int)sources.size(), [&](int si){
+                int i = sources[si];
+                DT *rowi = dm + (size_t)i*ld;
+                HT *nxi = hm + (size_t)i*ld;
+                DT diu = rowi[u];
+                vector<char> affected(n, 0);
+                vector<int> targets;
+                for(int j=0;j<n;++j){
+                    if(j==i || rowv[j] >= inf) continue;
+                    if(tied(Cell<DT>::add(Cell<DT>::add(diu, ow), rowv[j]), rowi[j])){ affected[j] = 1; targets.push_back(j); }
+                }
+                using P = pair<DT,int>;
+                priority_queue<P, vector<P>, greater<P>> pq;
+                for(int j: targets){
+                    DT best = inf; HT h = Hop<HT>::enc(-1);
+                    for(int x: preds[j]){
+                        if(affected[x] || rowi[x] >= inf) continue;
+                        DT nd = Cell<DT>::add(rowi[x], ew(x,j));
+                        if(nd < best){ best = nd; h = (x==i) ? Hop<HT>::enc(j) : nxi[x]; }
+                    }
+                    rowi[j] = best; nxi[j] = h;
+                    if(best < inf) pq.push({best, j});
+                }
+                while(!pq.empty()){
+                    auto [d,y] = pq.top(); pq.pop();
+                    if(d != rowi[y] || !affected[y]) continue;
+                    affected[y] = 0;
+                    for(int j: targets){
+                        if(!affected[j] || w[y][j] >= INF) continue;
+                        DT nd = Cell<DT>::add(d, ew(y,j));
+                        if(nd < rowi[j]){ rowi[j] = nd; nxi[j] = nxi[y]; pq.push({nd, j}); }
+                    }
+                }
+            });
+        });
+    }
 };
 
-struct BlockManager {
+struct CSR {
     int n;
-    int blockSize;
-    int blocks;
-    vector<vector<vector<D>>> blockDist;
-    BlockManager():n(0),blockSize(0),blocks(0){}
-    void init(int n_, int bSize){
+    vector<int> off;
+    vector<int> to;
+    vector<D> w;
+    CSR():n(0){}
+    void build(int n_, const vector<Edge> &edges){
         n = n_;
-        blockSize = max(1, bSize);
-        blocks = (n + blockSize - 1) / blockSize;
-        blockDist.assign(blocks, vector<vector<D>>(blocks, vector<D>(blockSize*blockSize, INF)));
+        off.assign(n+1, 0);
+        for(auto &e: edges) if(e.u>=0 && e.v>=0 && e.u<n && e.v<n && e.u!=e.v) ++off[e.u+1];
+        for(int i=0;i<n;++i) off[i+1] += off[i];
+        to.resize(off[n]); w.resize(off[n]);
+        vector<int> fill = off;
+        for(auto &e: edges) if(e.u>=0 && e.v>=0 && e.u<n && e.v<n && e.u!=e.v){
+            int p = fill[e.u]++;
+            to[p] = e.v; w[p] = e.w;
+        }
+    }
+    size_t m() const { return to.size(); }
+};
+
+struct SparseAPSP {
+    static bool potentials(const CSR &g, vector<D> &h){
+        h.assign(g.n, 0);
+        bool negative = false;
+        for(D x: g.w) if(x < 0){ negative = true; break; }
+        if(!negative) return true;
+        vector<int> cnt(g.n, 0);
+        vector<char> inq(g.n, 1);
+        deque<int> q;
+        for(int i=0;i<g.n;++i) q.push_back(i);
+        while(!q.empty()){
+            int u = q.front(); q.pop_front(); inq[u] = 0;
+            for(int p=g.off[u];p<g.off[u+1];++p){
+                int v = g.to[p];
+                if(h[u] + g.w[p] < h[v]){
+                    h[v] = h[u] + g.w[p];
+                    if(!inq[v]){
+                        if(++cnt[v] > g.n) return false;
+                        inq[v] = 1; q.push_back(v);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+    static bool compute(Floyd &fw, const CSR &g, ThreadPool &pool){
+        int n = g.n;
+        vector<D> h;
+        if(!potentials(g, h)) return false;
+        vector<D> rw(g.m());
+        for(int u=0;u<n;++u) for(int p=g.off[u];p<g.off[u+1];++p) rw[p] = g.w[p] + h[u] - h[g.to[p]];
+        int chunks = min(n, pool.size()*4);
+        fw.visit([&](auto *dm, auto *hm){
+            using DT = remove_pointer_t<decltype(dm)>;
+            using HT = remove_pointer_t<decltype(hm)>;
+            pool.parallel_for(chunks, [&](int c){
+                vector<D> dist(n, INF);
+                vector<int> first(n, -1);
+                vector<int> touched;
+                using P = pair<D,int>;
+                priority_queue<P, vector<P>, greater<P>> pq;
+                for(int s=c; s<n; s+=chunks){
+                    for(int x: touched){ dist[x] = INF; first[x] = -1; }
+                    touched.clear();
+                    dist[s] = 0; first[s] = s; touched.push_back(s);
+                    pq.push({0, s});
+                    while(!pq.empty()){
+                        auto [d,u] = pq.top(); pq.pop();
+                        if(d != dist[u]) continue;
+                        for(int p=g.off[u];p<g.off[u+1];++p){
+                            int v = g.to[p];
+                            D nd = d + rw[p];
+                            if(nd < dist[v]){
+                                if(dist[v] >= INF) touched.push_back(v);
+                                dist[v] = nd;
+                                first[v] = (u==s) ? v : first[u];
+                                pq.push({nd, v});
+                            }
+                        }
+                    }
+                    DT *rowd = dm + (size_t)s*fw.ld;
+                    HT *rowh = hm + (size_t)s*fw.ld;
+                    for(int x: touched){
+                        rowd[x] = Cell<DT>::enc(dist[x] - h[s] + h[x], fw.scale);
+                        rowh[x] = Hop<HT>::enc(first[x]);
+                    }
+                }
+            });
+        });
+        return true;
+    }
+};
+
+struct Centrality {
+    long long closenessVersion;
+    long long betweennessVersion;
+    vector<D> closeness;
+    vector<D> betweenness;
+    vector<int> byCloseness;
+    vector<int> byBetweenness;
+    Centrality():closenessVersion(-1),betweennessVersion(-1){}
+    static vector<int> rank_desc(const vector<D> &score){
+        vector<int> idx(score.size());
+        iota(idx.begin(), idx.end(), 0);
+        stable_sort(idx.begin(), idx.end(), [&](int a,int b){ return score[a] > score[b]; });
+        return idx;
+    }
+    void compute_closeness(int n, const function<void(int, vector<D>&)> &rowFn, ThreadPool &pool){
+        closeness.assign(n, 0.0);
+        int chunks = max(1, min(n, pool.size()*4));
+        pool.parallel_for(chunks, [&](int c){
+            vector<D> row(n);
+            for(int i=c;i<n;i+=chunks){
+                rowFn(i, row);
+                D sum = 0; int reach = 0;
+                for(int j=0;j<n;++j) if(j!=i && row[j] < INF){ sum += row[j]; ++reach; }
+                if(reach > 0 && sum > 0) closeness[i] = (D)reach*reach / ((D)(n-1)*sum);
+            }
+        });
+        byCloseness = rank_desc(closeness);
+    }
+    void compute_betweenness(const CSR &g, const CSR &rev, ThreadPool &pool){
+        int n = g.n;
+        vector<D> h;
+        vector<D> fw(g.m()), bw(rev.m());
+        bool ok = SparseAPSP::potentials(g, h);
+        for(int u=0;u<n;++u){
+            for(int p=g.off[u];p<g.off[u+1];++p) fw[p] = ok ? g.w[p] + h[u] - h[g.to[p]] : g.w[p];
+            for(int p=rev.off[u];p<rev.off[u+1];++p) bw[p] = ok ? rev.w[p] + h[rev.to[p]] - h[u] : rev.w[p];
+        }
+        int chunks = max(1, min(n, pool.size()*4));
+        vector<vector<D>> partial(chunks);
+        pool.parallel_for(chunks, [&](int c){
+            vector<D> &acc = partial[c];
+            acc.assign(n, 0.0);
+            vector<D> dist(n, INF), sigma(n, 0.0), delta(n, 0.0);
+            vector<int> order, topo, indeg(n, 0);
+            using P = pair<D,int>;
+            priority_queue<P, vector<P>, greater<P>> pq;
+            auto tight = [](D a,D b){ return fabs(a-b) <= 1e-9*max((D)1, fabs(b)); };
+            for(int s=c;s<n;s+=chunks){
+                for(int x: order){ dist[x] = INF; sigma[x] = 0; delta[x] = 0; indeg[x] = 0; }
+                order.clear();
+                dist[s] = 0; pq.push({0, s});
+                while(!pq.empty()){
+                    auto [d,u] = pq.top(); pq.pop();
+                    if(d != dist[u]) continue;
+                    order.push_back(u);
+                    for(int p=g.off[u];p<g.off[u+1];++p){
+                        int v = g.to[p];
+                        D nd = d + fw[p];
+                        if(nd < dist[v] && !tight(nd, dist[v])){ dist[v] = nd; pq.push({nd, v}); }
+                    }
+                }
+                auto tightIn = [&](int p, int v){ int u = rev.to[p]; return u != v && dist[u] < INF && tight(dist[u] + bw[p], dist[v]); };
+                for(int v: order) for(int p=rev.off[v];p<rev.off[v+1];++p) if(tightIn(p, v)) ++indeg[v];
+                topo.clear();
+                for(int v: order) if(indeg[v] == 0) pq.push({dist[v], v});
+                while(!pq.empty()){
+                    int u = pq.top().second; pq.pop();
+                    topo.push_back(u);
+                    for(int p=g.off[u];p<g.off[u+1];++p){
+                        int v = g.to[p];
+                        if(v != u && dist[v] < INF && tight(dist[u] + fw[p], dist[v]) && --indeg[v] == 0) pq.push({dist[v], v});
+                    }
+                }
+                if(topo.size() < order.size()) for(int v: order) if(indeg[v] > 0) topo.push_back(v);
+                order.swap(topo);
+                sigma[s] = 1;
+                for(int v: order){
+                    if(v == s) continue;
+                    for(int p=rev.off[v];p<rev.off[v+1];++p){
+                        int u = rev.to[p];
+                        if(tightIn(p, v)) sigma[v] += sigma[u];
+                    }
+                }
+                for(int q=(int)order.size()-1;q>=0;--q){
+                    int v = order[q];
+                    if(v == s) continue;
+                    for(int p=rev.off[v];p<rev.off[v+1];++p){
+                        int u = rev.to[p];
+                        if(tightIn(p, v) && sigma[v] > 0) delta[u] += sigma[u] / sigma[v] * (1.0 + delta[v]);
+                    }
+                    acc[v] += delta[v];
+                }
+            }
+        });
+        betweenness.assign(n, 0.0);
+        for(auto &acc: partial) for(int i=0;i<n;++i) betweenness[i] += acc[i];
+        byBetweenness = rank_desc(betweenness);
+    }
+    static vector<pair<int,D>> top(const vector<int> &order, const vector<D> &score, int k){
+        vector<pair<int,D>> out;
+        if(k < 0 || k > (int)order.size()) k = order.size();
+        for(int i=0;i<k;++i) out.push_back({order[i], score[order[i]]});
+        return out;
+    }
+};
+
+struct TileStore {
+    struct Tile {
+        vector<D, AlignedAlloc<D>> d;
+        vector<int32_t, AlignedAlloc<int32_t>> h;
+        bool dirty = false;
+        int pins = 0;
+        list<int>::iterator pos;
+    };
+    string file;
+    int fd;
+    int n, B, nb;
+    size_t capacity;
+    unordered_map<int, Tile> resident;
+    list<int> lru;
+    mutex mu;
+    long long hits, misses, writebacks;
+    TileStore():fd(-1),n(0),B(0),nb(0),capacity(0),hits(0),misses(0),writebacks(0){}
+    TileStore(const TileStore&) = delete;
+    TileStore& operator=(const TileStore&) = delete;
+    ~TileStore(){ if(fd >= 0){ flush(); ::close(fd); } }
+    size_t tile_bytes() const { return (size_t)B*B*(sizeof(D) + sizeof(int32_t)); }
+    off_t offset(int id) const { return (off_t)id * (off_t)tile_bytes(); }
+    bool open(const string &p, int n_, int B_, size_t budgetBytes, int threads){
+        file = p; n = n_; B = max(8, (B_ + 7) & ~7); nb = max(1, (n + B - 1) / B);
+        capacity = max(budgetBytes / tile_bytes(), (size_t)(nb + 3*threads + 2));
+        fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return false;
+        return ftruncate(fd, offset(nb*nb)) == 0;
+    }
+    bool read_tile(int id, Tile &t){
+        size_t db = (size_t)B*B*sizeof(D), hb = (size_t)B*B*sizeof(int32_t);
+        t.d.resize((size_t)B*B); t.h.resize((size_t)B*B);
+        return pread(fd, t.d.data(), db, offset(id)) == (ssize_t)db && pread(fd, t.h.data(), hb, offset(id) + db) == (ssize_t)hb;
+    }
+    bool write_tile(int id, const Tile &t){
+        size_t db = (size_t)B*B*sizeof(D), hb = (size_t)B*B*sizeof(int32_t);
+        ++writebacks;
+        return pwrite(fd, t.d.data(), db, offset(id)) == (ssize_t)db && pwrite(fd, t.h.data(), hb, offset(id) + db) == (ssize_t)hb;
+    }
+    void evict_locked(){
+        auto it = lru.end();
+        while(resident.size() >= capacity && it != lru.begin()){
+            --it;
+            auto rt = resident.find(*it);
+            if(rt->second.pins > 0) continue;
+            if(rt->second.dirty) write_tile(rt->first, rt->second);
+            it = lru.erase(it);
+            resident.erase(rt);
+        }
+    }
+    Tile& pin(int bi,int bj){
+        int id = bi*nb + bj;
+        lock_guard<mutex> lk(mu);
+        auto it = resident.find(id);
+        if(it != resident.end()){
+            ++hits;
+            lru.splice(lru.begin(), lru, it->second.pos);
+            ++it->second.pins;
+            return it->second;
+        }
+        ++misses;
+        evict_locked();
+        Tile &t = resident[id];
+        if(!read_tile(id, t)) throw runtime_error("tile read failed: " + file);
+        lru.push_front(id);
+        t.pos = lru.begin();
+        t.pins = 1;
+        return t;
+    }
+    void unpin(Tile &t, bool dirty){
+        lock_guard<mutex> lk(mu);
+        t.dirty = t.dirty || dirty;
+        --t.pins;
+    }
+    void flush(){
+        lock_guard<mutex> lk(mu);
+        for(auto &kv: resident) if(kv.second.dirty){ write_tile(kv.first, kv.second); kv.second.dirty = false; }
+    }
+    void load(const vector<Edge> &edges){
+        {
+            lock_guard<mutex> lk(mu);
+            resident.clear(); lru.clear();
+        }
+        vector<vector<const Edge*>> byTile((size_t)nb*nb);
+        for(auto &e: edges) if(e.u>=0 && e.u<n && e.v>=0 && e.v<n) byTile[(size_t)(e.u/B)*nb + e.v/B].push_back(&e);
+        Tile t;
+        for(int bi=0;bi<nb;++bi) for(int bj=0;bj<nb;++bj){
+            t.d.assign((size_t)B*B, INF);
+            t.h.assign((size_t)B*B, -1);
+            if(bi == bj) for(int r=0;r<B && bi*B+r<n;++r){ t.d[(size_t)r*B+r] = 0; t.h[(size_t)r*B+r] = bi*B+r; }
+            for(auto *e: byTile[(size_t)bi*nb + bj]){
+                size_t p = (size_t)(e->u - bi*B)*B + (e->v - bj*B);
+                if(e->w < t.d[p]){ t.d[p] = e->w; t.h[p] = e->v; }
+            }
+            write_tile(bi*nb + bj, t);
+        }
+    }
+    void relax(Tile &C, const Tile &A, const Tile &Bk){
+        for(int k=0;k<B;++k){
+            const D *rowk = Bk.d.data() + (size_t)k*B;
+            for(int i=0;i<B;++i){
+                D dik = A.d[(size_t)i*B + k];
+                if(dik >= INF) continue;
+                MinPlus::row(rowk, C.d.data() + (size_t)i*B, C.h.data() + (size_t)i*B, dik, A.h[(size_t)i*B + k], 0, B);
+            }
+        }
+    }
+    void compute(ThreadPool &pool){
+        for(int b=0;b<nb;++b){
+            Tile &K = pin(b,b);
+            relax(K, K, K);
+            pool.parallel_for(2*(nb-1), [&](int t){
+                int o = t % (nb-1); if(o >= b) ++o;
+                if(t < nb-1){ Tile &R = pin(b,o); relax(R, K, R); unpin(R, true); }
+                else { Tile &Cc = pin(o,b); relax(Cc, Cc, K); unpin(Cc, true); }
+            });
+            unpin(K, true);
+            pool.parallel_for(nb-1, [&](int t){
+                int bi = t >= b ? t+1 : t;
+                Tile &A = pin(bi,b);
+                for(int bj=0;bj<nb;++bj){
+                    if(bj == b) continue;
+                    Tile &R = pin(b,bj);
+                    Tile &Cc = pin(bi,bj);
+                    relax(Cc, A, R);
+                    unpin(Cc, true);
+                    unpin(R, false);
+                }
+                unpin(A, false);
+            });
+        }
+        flush();
+    }
+    D at(int i,int j){
+        Tile &t = pin(i/B, j/B);
+        D d = t.d[(size_t)(i%B)*B + j%B];
+        unpin(t, false);
+        return d;
+    }
+    int hop(int i,int j){
+        Tile &t = pin(i/B, j/B);
+        int h = t.h[(size_t)(i%B)*B + j%B];
+        unpin(t, false);
+        return h;
+    }
+    vector<D> row(int u){
+        vector<D> out(n, INF);
+        for(int bj=0;bj<nb;++bj){
+            Tile &t = pin(u/B, bj);
+            for(int c=0;c<B && bj*B+c<n;++c) out[bj*B+c] = t.d[(size_t)(u%B)*B + c];
+            unpin(t, false);
+        }
+        return out;
+    }
+    vector<int> path(int u,int v){
+        vector<int> out;
+        if(u<0||v<0||u>=n||v>=n) return out;
+        if(hop(u,v) == -1) return out;
+        int cur = u;
+        out.push_back(cur);
+        while(cur != v){
+            cur = hop(cur,v);
+            if(cur == -1 || (int)out.size() > n) return {};
+            out.push_back(cur);
+        }
+        return out;
+    }
+    D allpairs_sum(){
+        D s = 0;
+        for(int bi=0;bi<nb;++bi) for(int bj=0;bj<nb;++bj){
+            Tile &t = pin(bi,bj);
+            for(int r=0;r<B && bi*B+r<n;++r) for(int c=0;c<B && bj*B+c<n;++c){
+                D d = t.d[(size_t)r*B + c];
+                if(d < INF) s += d;
+            }
+            unpin(t, false);
+        }
+        return s;
     }
-    pair<int,int> idx2blk(int idx){ return { idx / blockSize, idx % blockSize }; }
 };
 
 struct GraphOps {
     int n;
     vector<Edge> edges;
     vector<vector<D>> baseDist;
-    GraphOps():n(0){}
+    vector<vector<int>> preds;
+    int negatives;
+    GraphOps():n(0),negatives(0){}
     void load(const vector<Edge> &e, int n_){
         edges = e; n = n_;
         baseDist.assign(n, vector<D>(n, INF));
+        preds.assign(n, {});
+        negatives = 0;
         for(int i=0;i<n;++i) baseDist[i][i] = 0;
-        for(auto &ed: edges) if(ed.u>=0 && ed.v>=0 && ed.u<n && ed.v<n) baseDist[ed.u][ed.v] = min(baseDist[ed.u][ed.v], ed.w);
-    }
-    vector<vector<D>> incremental_apsp(){
-        vector<vector<D>> dist = baseDist;
-        for(int k=0;k<n;++k){
-            for(int i=0;i<n;++i){
-                if(dist[i][k] >= INF) continue;
-                for(int j=0;j<n;++j){
-                    D nd = dist[i][k] + dist[k][j];
-                    if(nd < dist[i][j]) dist[i][j] = nd;
-                }
-            }
-        }
-        return dist;
-    }
-    vector<vector<D>> blockwise_apsp(int blockSize){
-        int B = (n + blockSize - 1)/blockSize;
-        vector<vector<D>> dist = baseDist;
-        for(int b=0;b<B;++b){
-            int kb = b*blockSize;
-            int kend = min(n, kb + blockSize);
-            for(int i=kb;i<kend;++i) for(int j=kb;j<kend;++j) if(dist[i][j] > dist[i][j]){}
-            for(int k=kb;k<kend;++k){
-                for(int i=0;i<n;++i){
-                    if(dist[i][k] >= INF) continue;
-                    for(int j=0;j<n;++j){
-                        D nd = dist[i][k] + dist[k][j];
-                        if(nd < dist[i][j]) dist[i][j] = nd;
-                    }
-                }
-            }
+        for(auto &ed: edges) if(ed.u>=0 && ed.v>=0 && ed.u<n && ed.v<n){
+            if(ed.u != ed.v && baseDist[ed.u][ed.v] >= INF) preds[ed.v].push_back(ed.u);
+            baseDist[ed.u][ed.v] = min(baseDist[ed.u][ed.v], ed.w);
+            if(ed.w < 0) ++negatives;
         }
-        return dist;
     }
-    vector<int> nodes_sorted_by_centrality(){
-        vector<D> sumd(n, 0.0);
-        auto Dmat = incremental_apsp();
-        for(int i=0;i<n;++i) for(int j=0;j<n;++j) if(Dmat[i][j] < INF) sumd[i] += Dmat[i][j];
-        vector<int> idx(n); iota(idx.begin(), idx.end(), 0);
-        sort(idx.begin(), idx.end(), [&](int a,int b){ return sumd[a] < sumd[b]; });
-        return idx;
+    bool in_range(int u,int v) const { return u>=0 && v>=0 && u<n && v<n; }
+    pair<D,D> set_edge(int u,int v,D w){
+        bool found=false;
+        for(auto &e: edges) if(e.u==u && e.v==v){
+            if(e.w < 0) --negatives;
+            e.w = w; found=true; break;
+        }
+        if(!found) edges.emplace_back(u,v,w);
+        if(w < 0) ++negatives;
+        if(!in_range(u,v) || u==v) return {INF, INF};
+        D old = baseDist[u][v], eff = INF;
+        for(auto &e: edges) if(e.u==u && e.v==v) eff = min(eff, e.w);
+        if(old >= INF) preds[v].push_back(u);
+        baseDist[u][v] = eff;
+        return {old, eff};
     }
 };
 
@@ -222,6 +1097,7 @@ struct IO {
 
 struct Bench {
     static long long now(){ return chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now().time_since_epoch()).count(); }
+    static long long now_us(){ return chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now().time_since_epoch()).count(); }
     static void timeit(function<void()> f, const string &label){
         long long s = now(); f(); long long e = now(); cerr<<label<<" "<<(e-s)<<" ms\n";
     }
@@ -230,27 +1106,110 @@ struct Bench {
 struct Controller {
     Floyd fw;
     GraphOps ops;
+    ThreadPool pool;
     int n;
-    Controller():n(0){}
+    bool incremental;
+    vector<Edge> snapEdges;
+    unique_ptr<TileStore> ooc;
+    string oocPath;
+    size_t oocBudget;
+    string engine;
+    string lastEngine;
+    long long graphVersion;
+    Centrality central;
+    Controller(int threads=0, int tile=64, DistMode mode=DistMode::F64, int hopBits=32):pool(threads),n(0),incremental(true),oocBudget(0),engine("auto"),graphVersion(0){
+        fw.tile = tile;
+        fw.configure(mode, hopBits);
+    }
+    bool enable_out_of_core(const string &path, size_t budgetBytes){
+        ooc.reset(new TileStore());
+        oocPath = path; oocBudget = budgetBytes;
+        return true;
+    }
     void load_graph(const string &csv){
         Loader L(csv);
         int nn; auto E = L.load(nn);
+        if(ooc){
+            ops.edges = E; ops.n = nn;
+            n = nn;
+            if(!ooc->open(oocPath, n, fw.tile, oocBudget, pool.size())) throw runtime_error("cannot open tile file " + oocPath);
+            ooc->load(ops.edges);
+            return;
+        }
         ops.load(E, nn);
         n = nn;
+    }
+    bool load_snapshot(const string &path, string &err){
+        if(!fw.map_snapshot(path, snapEdges, err)) return false;
+        n = fw.n;
+        ops = GraphOps();
+        return true;
+    }
+    bool save_snapshot(const string &path){
+        ensure_ops();
+        return fw.save_snapshot(path, ops.edges);
+    }
+    void ensure_ops(){
+        if(ops.n == n && (int)ops.baseDist.size() == n) return;
+        ops.load(snapEdges, n);
+        snapEdges.clear(); snapEdges.shrink_to_fit();
+    }
+    void ensure_owned(){
+        ensure_ops();
+        fw.thaw();
+    }
+    string pick_engine() const {
+        if(engine != "auto") return engine;
+        D m = (D)ops.edges.size(), nn = max(1, n);
+        return (m + nn) * log2(nn + 1) * 12 < nn * nn ? "dijkstra" : "floyd";
+    }
+    string run_apsp(){
+        string eng = pick_engine();
+        if(!fw.fit_scale(ops.edges, n)){
+            cerr<<"fixed: path costs exceed int32 range, using f64\n";
+            fw.configure(DistMode::F64, fw.hopBits);
+        }
         fw.init(n);
-        fw.load_edges(E);
+        if(eng == "dijkstra"){
+            CSR g; g.build(n, ops.edges);
+            if(SparseAPSP::compute(fw, g, pool)) return eng;
+            fw.init(n);
+            eng = "floyd";
+        }
+        fw.load_edges(ops.edges);
+        fw.compute(pool);
+        return eng;
     }
-    void compute_all(){
-        fw.compute();
+    string compute_all(){
+        if(ooc){ ooc->compute(pool); lastEngine = "floyd-ooc"; }
+        else lastEngine = run_apsp();
+        return lastEngine;
     }
+    D cost(int s,int t){ return ooc ? ooc->at(s,t) : fw.at(s,t); }
+    vector<int> path(int s,int t){ return ooc ? ooc->path(s,t) : fw.path(s,t); }
+    vector<D> row_from(int s){
+        if(ooc) return ooc->row(s);
+        vector<D> out(n);
+        for(int i=0;i<n;++i) out[i] = fw.at(s,i);
+        return out;
+    }
+    D allpairs_sum(){ return ooc ? ooc->allpairs_sum() : fw.allpairs_sum(); }
     vector<tuple<int,int,D,vector<int>>> batch_paths(const vector<pair<int,int>> &pairs){
         vector<tuple<int,int,D,vector<int>>> out;
-        for(auto &pr: pairs){
-            int s = pr.first, t = pr.second;
-            if(s<0||s>=n||t<0||t>=n){ out.emplace_back(s,t,INF,vector<int>()); continue; }
-            D cost = fw.dist[s][t];
-            auto p = fw.path(s,t);
-            out.emplace_back(s,t,cost,p);
+        vector<size_t> ord(pairs.size());
+        iota(ord.begin(), ord.end(), 0);
+        if(ooc){
+            int B = ooc->B;
+            stable_sort(ord.begin(), ord.end(), [&](size_t a,size_t b){
+                auto ka = make_pair(pairs[a].second/B, pairs[a].first/B), kb = make_pair(pairs[b].second/B, pairs[b].first/B);
+                return ka < kb;
+            });
+        }
+        out.resize(pairs.size());
+        for(size_t q: ord){
+            int s = pairs[q].first, t = pairs[q].second;
+            if(s<0||s>=n||t<0||t>=n){ out[q] = make_tuple(s,t,INF,vector<int>()); continue; }
+            out[q] = make_tuple(s,t,cost(s,t),path(s,t));
         }
         return out;
     }
@@ -258,28 +1217,143 @@ struct Controller {
         fw.export_matrix_csv(matrixOut);
         fw.export_next_csv(nextOut);
     }
-    vector<int> central_nodes(int k){
-        auto v = ops.nodes_sorted_by_centrality();
-        if(k < 0 || k > (int)v.size()) return v;
-        v.resize(k);
-        return v;
+    const vector<Edge>& current_edges() const { return snapEdges.empty() ? ops.edges : snapEdges; }
+    vector<pair<int,D>> central_nodes(int k, const string &metric){
+        if(metric == "betweenness"){
+            if(central.betweennessVersion != graphVersion){
+                auto &E = current_edges();
+                CSR g, rev;
+                g.build(n, E);
+                vector<Edge> rE; rE.reserve(E.size());
+                for(auto &e: E) rE.emplace_back(e.v, e.u, e.w);
+                rev.build(n, rE);
+                central.compute_betweenness(g, rev, pool);
+                central.betweennessVersion = graphVersion;
+            }
+            return Centrality::top(central.byBetweenness, central.betweenness, k);
+        }
+        if(central.closenessVersion != graphVersion){
+            central.compute_closeness(n, [&](int i, vector<D> &row){
+                if(ooc){ row = ooc->row(i); return; }
+                for(int j=0;j<n;++j) row[j] = fw.at(i,j);
+            }, pool);
+            central.closenessVersion = graphVersion;
+        }
+        return Centrality::top(central.byCloseness, central.closeness, k);
     }
-    vector<int> reachable_from(int u){ return fw.reachable_from(u); }
-    void update_edge_and_recompute(int u,int v,D w){
-        bool found=false;
-        for(auto &e: ops.edges) if(e.u==u && e.v==v){ e.w = w; found=true; break; }
-        if(!found) ops.edges.emplace_back(u,v,w);
+    vector<int> reachable_from(int u){
+        if(!ooc) return fw.reachable_from(u);
+        vector<int> out;
+        if(u<0||u>=n) return out;
+        auto r = ooc->row(u);
+        for(int v=0;v<n;++v) if(r[v] < INF && u!=v) out.push_back(v);
+        return out;
+    }
+    void set_precision(DistMode m, int hopBits){
+        ensure_owned();
+        fw.configure(m, hopBits);
+        recompute_full();
+    }
+    void bench_precision(ostream &os){
+        ensure_ops();
+        size_t nested = (size_t)n*n*(sizeof(D)+sizeof(int)) + (size_t)n*2*(sizeof(vector<D>)+16);
+        Floyd ref;
+        ref.tile = fw.tile;
+        ref.init(n); ref.load_edges(ops.edges);
+        long long s = Bench::now_us(); ref.compute(pool); long long refUs = max(1LL, Bench::now_us() - s);
+        Floyd probe;
+        probe.configure(DistMode::FIX32, 32);
+        bool fixOk = probe.fit_scale(ops.edges, n);
+        os<<"kernel="<<MinPlus::isa()<<" n="<<n<<" nested_f64_i32_bytes="<<nested<<" fixed_scale=";
+        if(fixOk) os<<probe.scale; else os<<"none";
+        os<<"\n";
+        os<<"mode,hops,bytes,saved_vs_nested,ms,speedup,max_abs_err\n";
+        vector<pair<DistMode,int>> cfgs = {{DistMode::F64,32},{DistMode::F64,16},{DistMode::F32,16},{DistMode::FIX32,16},{DistMode::F32,32},{DistMode::FIX32,32}};
+        for(auto &cfg: cfgs){
+            Floyd f;
+            f.tile = fw.tile;
+            f.configure(cfg.first, cfg.second);
+            if(!f.fit_scale(ops.edges, n)){
+                os<<dist_mode_name(cfg.first)<<","<<cfg.second<<",,,,,out-of-range\n";
+                continue;
+            }
+            f.init(n); f.load_edges(ops.edges);
+            long long t0 = Bench::now_us(); f.compute(pool); long long us = max(1LL, Bench::now_us() - t0);
+            D err = 0;
+            for(int i=0;i<n;++i) for(int j=0;j<n;++j){
+                D a = ref.at(i,j), b = f.at(i,j);
+                if((a >= INF) != (b >= INF)){ err = INF; continue; }
+                if(a < INF) err = max(err, fabs(a-b));
+            }
+            ios::fmtflags flags = os.flags();
+            streamsize prec = os.precision();
+            os<<dist_mode_name(cfg.first)<<","<<(f.hop16?16:32)<<","<<f.bytes()<<","<<fixed<<setprecision(1)<<100.0*(1.0 - (D)f.bytes()/nested)<<"%,"
+              <<setprecision(3)<<us/1000.0<<","<<(D)refUs/us<<"x,";
+            if(err >= INF) os<<"reachability-mismatch"; else os<<setprecision(6)<<err;
+            os<<"\n";
+            os.flags(flags);
+            os.precision(prec);
+        }
+    }
+    void recompute_full(){
+        ensure_ops();
         ops.load(ops.edges, ops.n);
-        fw.init(n);
-        fw.load_edges(ops.edges);
-        fw.compute();
+        lastEngine = run_apsp();
+    }
+    bool apply_edge_change(int u,int v,D oldw,D neww){
+        if(!fw.absorb(neww)) return false;
+        if(neww < oldw) return fw.relax_through(u, v, neww);
+        if(neww > oldw){
+            if(ops.negatives > 0) return false;
+            fw.repair_increase(u, v, oldw, ops.baseDist, ops.preds, pool);
+        }
+        return true;
+    }
+    void recompute_out_of_core(){
+        ooc->load(ops.edges);
+        ooc->compute(pool);
+    }
+    void update_edge_and_recompute(int u,int v,D w){
+        ++graphVersion;
+        if(ooc){
+            bool found=false;
+            for(auto &e: ops.edges) if(e.u==u && e.v==v){ e.w = w; found=true; break; }
+            if(!found) ops.edges.emplace_back(u,v,w);
+            recompute_out_of_core();
+            return;
+        }
+        ensure_owned();
+        if(!incremental){
+            ops.set_edge(u,v,w);
+            recompute_full();
+            return;
+        }
+        auto ch = ops.set_edge(u,v,w);
+        if(!apply_edge_change(u, v, ch.first, ch.second)) recompute_full();
     }
     void batch_update_edges(const vector<Edge> &additions){
-        for(auto &e: additions) ops.edges.push_back(e);
-        ops.load(ops.edges, ops.n);
-        fw.init(n);
-        fw.load_edges(ops.edges);
-        fw.compute();
+        ++graphVersion;
+        if(ooc){
+            for(auto &e: additions) ops.edges.push_back(e);
+            recompute_out_of_core();
+            return;
+        }
+        ensure_owned();
+        if(!incremental || (long long)additions.size()*4 > n){
+            for(auto &e: additions) ops.edges.push_back(e);
+            recompute_full();
+            return;
+        }
+        for(auto &e: additions){
+            ops.edges.push_back(e);
+            if(e.w < 0) ++ops.negatives;
+            if(!ops.in_range(e.u,e.v) || e.u==e.v) continue;
+            D old = ops.baseDist[e.u][e.v];
+            if(e.w >= old) continue;
+            if(old >= INF) ops.preds[e.v].push_back(e.u);
+            ops.baseDist[e.u][e.v] = e.w;
+            if(!fw.absorb(e.w) || !fw.relax_through(e.u, e.v, e.w)){ recompute_full(); return; }
+        }
     }
 };
 
@@ -292,13 +1366,39 @@ static vector<string> split_ws(const string &s){
 int main(int argc,char**argv){
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
-    if(argc < 2){ cerr<<"Usage: "<<argv[0]<<" <edges.csv>\n"; return 1; }
-    string csv = argv[1];
-    Controller ctl;
-    Bench::timeit([&](){ ctl.load_graph(csv); }, "load_graph");
-    Bench::timeit([&](){ ctl.compute_all(); }, "floyd_compute");
-    cout<<"nodes="<<ctl.n<<" edges="<<ctl.ops.edges.size()<<"\n";
-    cout<<"commands:\npath s t\nbatchpairs file out.csv\nexport matrix.csv next.csv\ncentral k\nreachable u\nupdate u v w\nbatchupdate file\nnearest s k\nsum\nexit\n";
+    vector<string> args;
+    string oocFile; long long oocMb = 0;
+    for(int i=1;i<argc;++i){
+        string a = argv[i];
+        if(a=="--ooc" && i+2<argc){ oocFile = argv[i+1]; oocMb = stoll(argv[i+2]); i += 2; }
+        else args.push_back(a);
+    }
+    if(args.empty()){ cerr<<"Usage: "<<argv[0]<<" <edges.csv|snapshot.fws> [tile] [threads] [f64|f32|fixed] [auto|16|32] [--ooc tiles.bin budget_mb]\n"; return 1; }
+    string csv = args[0];
+    int tile = args.size() > 1 ? stoi(args[1]) : 64;
+    int threads = args.size() > 2 ? stoi(args[2]) : 0;
+    DistMode mode = DistMode::F64;
+    if(args.size() > 3 && !parse_dist_mode(args[3], mode)){ cerr<<"unknown precision "<<args[3]<<"\n"; return 1; }
+    int hopBits = args.size() > 4 ? (args[4]=="auto" ? 0 : stoi(args[4])) : (mode == DistMode::F64 ? 32 : 0);
+    Controller ctl(threads, tile, mode, hopBits);
+    if(!oocFile.empty()){
+        if(Snapshot::is_snapshot(csv)){ cerr<<"--ooc needs an edge csv\n"; return 1; }
+        ctl.enable_out_of_core(oocFile, (size_t)max(1LL, oocMb) << 20);
+    }
+    if(Snapshot::is_snapshot(csv)){
+        string err; bool ok = false;
+        Bench::timeit([&](){ ok = ctl.load_snapshot(csv, err); }, "snapshot_map");
+        if(!ok){ cerr<<"snapshot: "<<err<<"\n"; return 1; }
+    } else {
+        Bench::timeit([&](){ ctl.load_graph(csv); }, "load_graph");
+        string label = "apsp_compute";
+        Bench::timeit([&](){ label += " engine=" + ctl.compute_all(); }, label);
+    }
+    if(ctl.ooc) cerr<<"ooc tile="<<ctl.ooc->B<<" tiles="<<ctl.ooc->nb*ctl.ooc->nb<<" cache="<<ctl.ooc->capacity<<" hits="<<ctl.ooc->hits<<" misses="<<ctl.ooc->misses<<" writebacks="<<ctl.ooc->writebacks<<"\n";
+    cout<<"nodes="<<ctl.n<<" edges="<<(ctl.fw.mapped() ? ctl.snapEdges.size() : ctl.ops.edges.size())<<" tile="<<ctl.fw.tile<<" threads="<<ctl.pool.size()<<" precision="<<dist_mode_name(ctl.fw.mode)<<"/"<<(ctl.fw.hop16?16:32);
+    if(ctl.fw.mode == DistMode::FIX32) cout<<" scale="<<ctl.fw.scale;
+    cout<<" kernel="<<MinPlus::isa()<<"\n";
+    cout<<"commands:\npath s t\nbatchpairs file out.csv\nexport matrix.csv next.csv\nsnapshot out.fws\nverify\ncentral k [closeness|betweenness]\nreachable u\nupdate u v w\nbatchupdate file\nnearest s k\nmode full|incremental\nengine auto|floyd|dijkstra\nprecision f64|f32|fixed [auto|16|32]\nbench precision\nsum\nexit\n";
     string line;
     while(true){
         cout<<"> ";
@@ -308,11 +1408,15 @@ int main(int argc,char**argv){
         if(parts.empty()) continue;
         string cmd = parts[0];
         if(cmd=="exit" || cmd=="quit") break;
+        if(ctl.ooc && (cmd=="engine" || cmd=="export" || cmd=="snapshot" || cmd=="verify" || cmd=="mode" || cmd=="precision" || cmd=="bench")){
+            cout<<cmd<<" is not available in out-of-core mode\n";
+            continue;
+        }
         if(cmd=="path"){
             if(parts.size()<3){ cout<<"path s t\n"; continue; }
             int s = stoi(parts[1]), t = stoi(parts[2]);
-            auto p = ctl.fw.path(s,t);
-            if(p.empty()) cout<<"no path\n"; else { cout<<"cost="<<ctl.fw.dist[s][t]<<" path:"; for(size_t i=0;i<p.size();++i){ if(i) cout<<"-"; cout<<p[i]; } cout<<"\n"; }
+            auto p = ctl.path(s,t);
+            if(p.empty()) cout<<"no path\n"; else { cout<<"cost="<<ctl.cost(s,t)<<" path:"; for(size_t i=0;i<p.size();++i){ if(i) cout<<"-"; cout<<p[i]; } cout<<"\n"; }
             continue;
         }
         if(cmd=="batchpairs"){
@@ -330,10 +1434,25 @@ int main(int argc,char**argv){
             cout<<"exported\n";
             continue;
         }
+        if(cmd=="snapshot"){
+            if(parts.size()<2){ cout<<"snapshot out.fws\n"; continue; }
+            bool ok = false;
+            Bench::timeit([&](){ ok = ctl.save_snapshot(parts[1]); }, "snapshot_write");
+            cout<<(ok ? "wrote " + parts[1] : "snapshot failed")<<"\n";
+            continue;
+        }
+        if(cmd=="verify"){
+            if(!ctl.fw.mapped()){ cout<<"not mapped\n"; continue; }
+            cout<<(ctl.fw.verify_snapshot() ? "checksum ok" : "checksum mismatch")<<"\n";
+            continue;
+        }
         if(cmd=="central"){
             int k=10; if(parts.size()>1) k = stoi(parts[1]);
-            auto v = ctl.central_nodes(k);
-            for(auto x: v) cout<<x<<"\n";
+            string metric = parts.size()>2 ? parts[2] : "closeness";
+            if(metric!="closeness" && metric!="betweenness"){ cout<<"central k [closeness|betweenness]\n"; continue; }
+            vector<pair<int,D>> v;
+            Bench::timeit([&](){ v = ctl.central_nodes(k, metric); }, "central_" + metric);
+            for(auto &x: v) cout<<x.first<<","<<x.second<<"\n";
             continue;
         }
         if(cmd=="reachable"){
@@ -363,14 +1482,47 @@ int main(int argc,char**argv){
         if(cmd=="nearest"){
             if(parts.size()<3){ cout<<"nearest s k\n"; continue; }
             int s = stoi(parts[1]), k = stoi(parts[2]);
+            if(s<0||s>=ctl.n){ cout<<"invalid\n"; continue; }
             vector<pair<D,int>> nodes;
-            for(int i=0;i<ctl.n;++i) if(i!=s && ctl.fw.dist[s][i] < INF) nodes.push_back({ctl.fw.dist[s][i], i});
+            auto r = ctl.row_from(s);
+            for(int i=0;i<ctl.n;++i) if(i!=s && r[i] < INF) nodes.push_back({r[i], i});
             sort(nodes.begin(), nodes.end());
             for(int i=0;i< (int)nodes.size() && i<k; ++i) cout<<nodes[i].second<<","<<nodes[i].first<<"\n";
             continue;
         }
+        if(cmd=="mode"){
+            if(parts.size()<2){ cout<<"mode "<<(ctl.incremental?"incremental":"full")<<"\n"; continue; }
+            ctl.incremental = parts[1]!="full";
+            cout<<"mode "<<(ctl.incremental?"incremental":"full")<<"\n";
+            continue;
+        }
+        if(cmd=="engine"){
+            if(parts.size()<2){ cout<<"engine "<<ctl.engine<<" last="<<ctl.lastEngine<<"\n"; continue; }
+            if(parts[1]!="auto" && parts[1]!="floyd" && parts[1]!="dijkstra"){ cout<<"engine auto|floyd|dijkstra\n"; continue; }
+            ctl.engine = parts[1];
+            string label = "apsp_compute";
+            Bench::timeit([&](){ ctl.ensure_owned(); ctl.recompute_full(); label += " engine=" + ctl.lastEngine; }, label);
+            cout<<"engine "<<ctl.engine<<" ran "<<ctl.lastEngine<<"\n";
+            continue;
+        }
+        if(cmd=="precision"){
+            DistMode m;
+            if(parts.size()<2 || !parse_dist_mode(parts[1], m)){ cout<<"precision f64|f32|fixed [auto|16|32]\n"; continue; }
+            int bits = parts.size()>2 ? (parts[2]=="auto" ? 0 : stoi(parts[2])) : 0;
+            size_t before = ctl.fw.bytes();
+            Bench::timeit([&](){ ctl.set_precision(m, bits); }, "precision_recompute");
+            cout<<"precision="<<dist_mode_name(ctl.fw.mode)<<"/"<<(ctl.fw.hop16?16:32)<<" bytes="<<ctl.fw.bytes()<<" (was "<<before<<")";
+            if(ctl.fw.mode == DistMode::FIX32) cout<<" scale="<<ctl.fw.scale;
+            cout<<"\n";
+            continue;
+        }
+        if(cmd=="bench"){
+            if(parts.size()<2 || parts[1]!="precision"){ cout<<"bench precision\n"; continue; }
+            ctl.bench_precision(cout);
+            continue;
+        }
         if(cmd=="sum"){
-            cout<<"allpairs_sum="<<ctl.fw.allpairs_sum()<<"\n";
+            cout<<"allpairs_sum="<<ctl.allpairs_sum()<<"\n";
             continue;
         }
         cout<<"unknown\n";
@@ -28,6 +28,10 @@ struct DSU {
         while(p[a]!=a){ p[a]=p[p[a]]; a=p[a]; }
         return a;
     }
+    int root(int a) const {
+        while(p[a]!=a) a=p[a];
+        return a;
+    }
     bool unite(int a,int b){
         a=find(a); b=find(b);
         if(a==b) return false;
@@ -94,32 +98,179 @@ struct GraphLoader {
     }
 };
 
+enum class MstBackend { Kruskal, FilterKruskal };
+
+static const char* mst_backend_name(MstBackend b){ return b==MstBackend::FilterKruskal ? "filter" : "kruskal"; }
+
+static bool parse_mst_backend(const string &s, MstBackend &b){
+    if(s=="kruskal"){ b = MstBackend::Kruskal; return true; }
+    if(s=="filter"){ b = MstBackend::FilterKruskal; return true; }
+    return false;
+}
+
+template<class Pred>
+static void parallel_split(const vector<int> &in, int threads, Pred pred, vector<int> &yes, vector<int> &no){
+    if(threads<=1 || in.size() < (1u<<16)){
+        for(int x: in) (pred(x) ? yes : no).push_back(x);
+        return;
+    }
+    vector<vector<int>> ys(threads), ns(threads);
+    vector<thread> pool;
+    size_t chunk = (in.size()+threads-1)/threads;
+    for(int t=0;t<threads;++t) pool.emplace_back([&,t](){
+        size_t b = t*chunk, e = min(in.size(), b+chunk);
+        for(size_t i=b;i<e;++i) (pred(in[i]) ? ys[t] : ns[t]).push_back(in[i]);
+    });
+    for(auto &th: pool) th.join();
+    for(int t=0;t<threads;++t){ yes.insert(yes.end(), ys[t].begin(), ys[t].end()); no.insert(no.end(), ns[t].begin(), ns[t].end()); }
+}
+
+struct SpanningTree {
+    double cost = 0.0;
+    vector<int> edges;
+};
+
+struct MaxEdgeLCA {
+    int n = 0, LOG = 1;
+    const vector<Edge> *E = nullptr;
+    vector<int> depth, comp;
+    vector<vector<int>> up, best;
+    int pick(int a, int b) const {
+        if(a < 0) return b;
+        if(b < 0) return a;
+        return (*E)[a].w >= (*E)[b].w ? a : b;
+    }
+    void build(int n_, const vector<Edge> &edges, const vector<int> &tree, const vector<char> &forced){
+        n = n_; E = &edges;
+        LOG = 1; while((1<<LOG) < max(2,n)) ++LOG;
+        vector<vector<pair<int,int>>> adj(n);
+        for(int id: tree){ adj[edges[id].u].push_back({edges[id].v, id}); adj[edges[id].v].push_back({edges[id].u, id}); }
+        depth.assign(n, -1); comp.assign(n, -1);
+        up.assign(LOG, vector<int>(n)); best.assign(LOG, vector<int>(n, -1));
+        vector<int> stk;
+        for(int r=0;r<n;++r){
+            if(depth[r] >= 0) continue;
+            depth[r] = 0; comp[r] = r; up[0][r] = r; stk.push_back(r);
+            while(!stk.empty()){
+                int u = stk.back(); stk.pop_back();
+                for(auto &pr: adj[u]){
+                    int v = pr.first;
+                    if(depth[v] >= 0) continue;
+                    depth[v] = depth[u] + 1; comp[v] = r; up[0][v] = u;
+                    best[0][v] = forced[pr.second] ? -1 : pr.second;
+                    stk.push_back(v);
+                }
+            }
+        }
+        for(int j=1;j<LOG;++j) for(int v=0;v<n;++v){
+            int mid = up[j-1][v];
+            up[j][v] = up[j-1][mid];
+            best[j][v] = pick(best[j-1][v], best[j-1][mid]);
+        }
+    }
+    int query(int a, int b) const {
+        if(a == b || comp[a] != comp[b]) return -1;
+        int res = -1;
+        if(depth[a] < depth[b]) swap(a, b);
+        for(int j=LOG-1;j>=0;--j) if(depth[a] - (1<<j) >= depth[b]){ res = pick(res, best[j][a]); a = up[j][a]; }
+        if(a == b) return res;
+        for(int j=LOG-1;j>=0;--j) if(up[j][a] != up[j][b]){ res = pick(res, pick(best[j][a], best[j][b])); a = up[j][a]; b = up[j][b]; }
+        return pick(res, pick(best[0][a], best[0][b]));
+    }
+};
+
 struct KruskalSolver {
     vector<Edge> edges;
+    vector<char> removed;
+    vector<int> order;
     int n;
     KruskalSolver():n(0){}
     void load_from_csv(const string &path){
         GraphLoader gl(path);
         int nout=0;
         edges = gl.load_edges(nout);
+        removed.assign(edges.size(), 0);
         n = nout;
     }
-    pair<vector<Edge>, double> mst_kruskal(){
+    bool key_less(int a,int b) const {
+        if(edges[a].w==edges[b].w) return edges[a].id < edges[b].id;
+        return edges[a].w < edges[b].w;
+    }
+    void filter_kruskal(vector<int> &ids, DSU &dsu, vector<int> &out, int threads){
+        if((int)out.size() >= n-1 || ids.empty()) return;
+        if(ids.size() <= 4096){
+            sort(ids.begin(), ids.end(), [&](int a,int b){ return key_less(a,b); });
+            for(int idx: ids){
+                if(dsu.unite(edges[idx].u, edges[idx].v)){
+                    out.push_back(idx);
+                    if((int)out.size() == n-1) break;
+                }
+            }
+            return;
+        }
+        int a = ids[ids.size()/4], b = ids[ids.size()/2], c = ids[3*ids.size()/4];
+        if(key_less(b,a)) swap(a,b);
+        if(key_less(c,b)) swap(b,c);
+        if(key_less(b,a)) swap(a,b);
+        int pivot = b;
+        vector<int> lo, hi;
+        parallel_split(ids, threads, [&](int idx){ return !key_less(pivot, idx); }, lo, hi);
+        vector<int>().swap(ids);
+        filter_kruskal(lo, dsu, out, threads);
+        if((int)out.size() >= n-1) return;
+        vector<int> keep, drop;
+        parallel_split(hi, threads, [&](int idx){ return dsu.root(edges[idx].u) != dsu.root(edges[idx].v); }, keep, drop);
+        vector<int>().swap(hi);
+        filter_kruskal(keep, dsu, out, threads);
+    }
+    vector<int> mst_filter_kruskal(int threads){
+        vector<int> out;
+        if(n<=0) return out;
+        vector<int> ids;
+        for(size_t i=0;i<edges.size(); ++i) if(!removed[i]) ids.push_back(i);
+        DSU dsu(n);
+        filter_kruskal(ids, dsu, out, max(1,threads));
+        return out;
+    }
+    pair<vector<Edge>, double> mst_with(MstBackend backend, int threads){
+        if(backend == MstBackend::Kruskal) return mst_kruskal();
         vector<Edge> out;
         double total=0.0;
-        if(n<=0) return {out,total};
-        vector<int> ord(edges.size());
-        for(size_t i=0;i<edges.size(); ++i) ord[i]=i;
-        sort(ord.begin(), ord.end(), [&](int a,int b){ if(edges[a].w==edges[b].w) return edges[a].id < edges[b].id; return edges[a].w < edges[b].w; });
+        for(int idx: mst_filter_kruskal(threads)){
+            out.push_back(edges[idx]);
+            total += edges[idx].w;
+        }
+        return {out, total};
+    }
+    const vector<int>& sorted_order(){
+        if(order.size() != edges.size()){
+            order.resize(edges.size());
+            for(size_t i=0;i<edges.size(); ++i) order[i]=i;
+            sort(order.begin(), order.end(), [&](int a,int b){ if(edges[a].w==edges[b].w) return edges[a].id < edges[b].id; return edges[a].w < edges[b].w; });
+        }
+        return order;
+    }
+    vector<int> mst_indices(){
+        vector<int> out;
+        if(n<=0) return out;
         DSU dsu(n);
-        for(int idx: ord){
+        for(int idx: sorted_order()){
             auto &e = edges[idx];
+            if(removed[idx]) continue;
             if(dsu.unite(e.u, e.v)){
-                out.push_back(e);
-                total += e.w;
+                out.push_back(idx);
                 if((int)out.size() == n-1) break;
             }
         }
+        return out;
+    }
+    pair<vector<Edge>, double> mst_kruskal(){
+        vector<Edge> out;
+        double total=0.0;
+        for(int idx: mst_indices()){
+            out.push_back(edges[idx]);
+            total += edges[idx].w;
+        }
         return {out, total};
     }
     vector<vector<pair<int,double>>> build_adj_from_mst(const vector<Edge> &mst){
@@ -135,6 +286,7 @@ struct KruskalSolver {
     vector<vector<pair<int,double>>> build_adj_full(){
         vector<vector<pair<int,double>>> adj(n);
         for(auto &e: edges){
+            if(removed[e.id]) continue;
             if(e.u>=0 && e.u<n && e.v>=0 && e.v<n){
                 adj[e.u].push_back({e.v, e.w});
                 adj[e.v].push_back({e.u, e.w});
@@ -142,50 +294,381 @@ struct KruskalSolver {
         }
         return adj;
     }
-    vector<pair<int,int>> cluster_by_threshold(double threshold){
+    vector<SpanningTree> k_best_spanning_trees(int k){
+        vector<SpanningTree> out;
+        if(n<=0 || k<=0) return out;
+        SpanningTree base;
+        base.edges = mst_indices();
+        for(int id: base.edges) base.cost += edges[id].w;
+        struct Node { double cost; SpanningTree tree; vector<int> forced, excluded; int out, in; };
+        auto cmp = [](const Node &a, const Node &b){ return a.cost > b.cost; };
+        priority_queue<Node, vector<Node>, decltype(cmp)> pq(cmp);
+        MaxEdgeLCA lca;
+        vector<char> forcedMask(edges.size(), 0), excludedMask(edges.size(), 0), inTree(edges.size(), 0);
+        auto push = [&](SpanningTree tree, vector<int> forced, vector<int> excluded){
+            for(int id: forced) forcedMask[id] = 1;
+            for(int id: excluded) excludedMask[id] = 1;
+            for(int id: tree.edges) inTree[id] = 1;
+            lca.build(n, edges, tree.edges, forcedMask);
+            double bestDelta = numeric_limits<double>::infinity();
+            int bestOut = -1, bestIn = -1;
+            for(int g=0; g<(int)edges.size(); ++g){
+                if(inTree[g] || excludedMask[g] || removed[g]) continue;
+                int f = lca.query(edges[g].u, edges[g].v);
+                if(f < 0) continue;
+                double delta = edges[g].w - edges[f].w;
+                if(delta < bestDelta){ bestDelta = delta; bestOut = f; bestIn = g; }
+            }
+            for(int id: forced) forcedMask[id] = 0;
+            for(int id: excluded) excludedMask[id] = 0;
+            for(int id: tree.edges) inTree[id] = 0;
+            if(bestOut < 0) return;
+            double cost = tree.cost + bestDelta;
+            pq.push({cost, move(tree), move(forced), move(excluded), bestOut, bestIn});
+        };
+        out.push_back(base);
+        push(base, {}, {});
+        while((int)out.size() < k && !pq.empty()){
+            Node cur = pq.top(); pq.pop();
+            SpanningTree next = cur.tree;
+            *find(next.edges.begin(), next.edges.end(), cur.out) = cur.in;
+            next.cost = cur.cost;
+            out.push_back(next);
+            auto withOut = cur.forced; withOut.push_back(cur.out);
+            auto withoutOut = cur.excluded; withoutOut.push_back(cur.out);
+            push(cur.tree, withOut, cur.excluded);
+            push(next, cur.forced, withoutOut);
+        }
+        return out;
+    }
+};
+
+struct ClusterTree {
+    int n;
+    vector<int> parent;
+    vector<int> sz;
+    vector<int> minLeaf;
+    vector<double> weight;
+    vector<double> merges;
+    ClusterTree():n(0){}
+    void build(int n_, const vector<Edge> &mst){
+        n = n_;
+        vector<const Edge*> ord;
+        for(auto &e: mst) ord.push_back(&e);
+        sort(ord.begin(), ord.end(), [](const Edge *a, const Edge *b){ if(a->w==b->w) return a->id < b->id; return a->w < b->w; });
+        parent.assign(n, -1);
+        sz.assign(n, 1);
+        minLeaf.resize(n);
+        for(int i=0;i<n;++i) minLeaf[i]=i;
+        weight.assign(n, -numeric_limits<double>::infinity());
+        merges.clear();
         DSU dsu(n);
-        for(auto &e: edges){
-            if(e.w <= threshold) dsu.unite(e.u, e.v);
-        }
-        unordered_map<int,int> compmap;
-        int cnt=0;
-        vector<pair<int,int>> compSizes;
-        for(int i=0;i<n;++i){
-            int r = dsu.find(i);
-            if(!compmap.count(r)) compmap[r] = cnt++;
-        }
-        vector<int> sizes(cnt,0);
-        for(int i=0;i<n;++i) sizes[compmap[dsu.find(i)]]++;
-        for(int i=0;i<cnt;++i) compSizes.push_back({i, sizes[i]});
-        return compSizes;
-    }
-    vector<Edge> k_shortest_mst_variants(int k){
-        vector<Edge> base = mst_kruskal().first;
-        vector<Edge> result = base;
-        for(int attempt=0; attempt<k-1; ++attempt){
-            if(edges.empty()) break;
-            int ridx = attempt % edges.size();
-            Edge blocked = edges[ridx];
-            vector<Edge> cand;
-            double total=0.0;
-            vector<int> ord(edges.size());
-            for(size_t i=0;i<edges.size(); ++i) ord[i]=i;
-            sort(ord.begin(), ord.end(), [&](int a,int b){ if(edges[a].id==blocked.id) return false; if(edges[b].id==blocked.id) return true; if(edges[a].w==edges[b].w) return edges[a].id < edges[b].id; return edges[a].w < edges[b].w; });
-            DSU dsu(n);
-            for(int idx: ord){
-                auto &e = edges[idx];
-                if(e.id == blocked.id) continue;
-                if(dsu.unite(e.u, e.v)){
-                    cand.push_back(e);
-                    total += e.w;
-                    if((int)cand.size() == n-1) break;
+        vector<int> top(n);
+        for(int i=0;i<n;++i) top[i]=i;
+        for(auto *e: ord){
+            int a = dsu.find(e->u), b = dsu.find(e->v);
+            if(a==b) continue;
+            int node = parent.size();
+            int ta = top[a], tb = top[b];
+            parent[ta] = parent[tb] = node;
+            parent.push_back(-1);
+            sz.push_back(sz[ta]+sz[tb]);
+            minLeaf.push_back(min(minLeaf[ta], minLeaf[tb]));
+            weight.push_back(e->w);
+            merges.push_back(e->w);
+            dsu.unite(a, b);
+            top[dsu.find(a)] = node;
+        }
+    }
+    int count_at(double t) const {
+        return n - (int)(upper_bound(merges.begin(), merges.end(), t) - merges.begin());
+    }
+    vector<int> cut_at(double t) const {
+        vector<int> cuts;
+        for(int v=0; v<(int)parent.size(); ++v)
+            if(weight[v] <= t && (parent[v]<0 || weight[parent[v]] > t)) cuts.push_back(v);
+        sort(cuts.begin(), cuts.end(), [&](int a,int b){ return minLeaf[a] < minLeaf[b]; });
+        return cuts;
+    }
+    vector<pair<int,int>> components_at(double t) const {
+        vector<pair<int,int>> out;
+        auto cuts = cut_at(t);
+        for(size_t i=0;i<cuts.size();++i) out.push_back({(int)i, sz[cuts[i]]});
+        return out;
+    }
+    vector<int> labels_at(double t) const {
+        auto cuts = cut_at(t);
+        vector<int> lab(parent.size(), -1);
+        for(size_t i=0;i<cuts.size();++i) lab[cuts[i]] = i;
+        for(int v=(int)parent.size()-1; v>=0; --v) if(lab[v]<0 && parent[v]>=0) lab[v] = lab[parent[v]];
+        lab.resize(n);
+        return lab;
+    }
+};
+
+struct TreeOracle {
+    int n;
+    vector<int> parent, depth, comp, first, euler, lg;
+    vector<double> rootDist;
+    vector<vector<int>> sparse;
+    TreeOracle():n(0){}
+    void build(const vector<vector<pair<int,double>>> &adj){
+        n = adj.size();
+        parent.assign(n, -1); depth.assign(n, 0); comp.assign(n, -1); first.assign(n, 0);
+        rootDist.assign(n, 0.0);
+        euler.clear();
+        vector<pair<int,size_t>> stk;
+        for(int r=0;r<n;++r){
+            if(comp[r] >= 0) continue;
+            comp[r] = r; first[r] = euler.size(); euler.push_back(r);
+            stk.push_back({r, 0});
+            while(!stk.empty()){
+                auto &top = stk.back();
+                int u = top.first;
+                if(top.second == adj[u].size()){
+                    stk.pop_back();
+                    if(!stk.empty()) euler.push_back(stk.back().first);
+                    continue;
                 }
+                auto &pr = adj[u][top.second++];
+                int v = pr.first;
+                if(comp[v] >= 0) continue;
+                comp[v] = r; parent[v] = u; depth[v] = depth[u]+1; rootDist[v] = rootDist[u] + pr.second;
+                first[v] = euler.size(); euler.push_back(v);
+                stk.push_back({v, 0});
             }
-            if((int)cand.size()==n-1){
-                for(auto &e: cand) result.push_back(e);
+        }
+        int m = euler.size();
+        lg.assign(m+1, 0);
+        for(int i=2;i<=m;++i) lg[i] = lg[i/2]+1;
+        sparse.assign(lg[max(1,m)]+1, vector<int>());
+        sparse[0] = euler;
+        for(int j=1;j<(int)sparse.size();++j){
+            int len = m - (1<<j) + 1;
+            sparse[j].resize(max(0,len));
+            for(int i=0;i<len;++i){
+                int a = sparse[j-1][i], b = sparse[j-1][i+(1<<(j-1))];
+                sparse[j][i] = depth[a] <= depth[b] ? a : b;
             }
         }
-        return result;
+    }
+    bool valid(int a) const { return a>=0 && a<n; }
+    int lca(int a,int b) const {
+        if(!valid(a) || !valid(b) || comp[a]!=comp[b]) return -1;
+        int l = first[a], r = first[b];
+        if(l > r) swap(l, r);
+        int j = lg[r-l+1];
+        int x = sparse[j][l], y = sparse[j][r-(1<<j)+1];
+        return depth[x] <= depth[y] ? x : y;
+    }
+    double distance(int a,int b) const {
+        int c = lca(a,b);
+        if(c < 0) return 1e18;
+        return rootDist[a] + rootDist[b] - 2*rootDist[c];
+    }
+    vector<int> path(int a,int b) const {
+        vector<int> out;
+        int c = lca(a,b);
+        if(c < 0) return out;
+        for(int x=a; x!=c; x=parent[x]) out.push_back(x);
+        out.push_back(c);
+        size_t mid = out.size();
+        for(int x=b; x!=c; x=parent[x]) out.push_back(x);
+        reverse(out.begin()+mid, out.end());
+        return out;
+    }
+};
+
+struct LinkCutTree {
+    vector<array<int,2>> ch;
+    vector<int> par, mx, tag;
+    vector<char> rev;
+    vector<double> w;
+    int add(double weight, int id){
+        ch.push_back({-1,-1}); par.push_back(-1); rev.push_back(0);
+        w.push_back(weight); tag.push_back(id);
+        mx.push_back(ch.size()-1);
+        return ch.size()-1;
+    }
+    bool heavier(int a, int b) const {
+        if(w[a]==w[b]) return tag[a] > tag[b];
+        return w[a] > w[b];
+    }
+    bool is_root(int x) const { return par[x]<0 || (ch[par[x]][0]!=x && ch[par[x]][1]!=x); }
+    void pull(int x){
+        mx[x] = x;
+        for(int c: ch[x]) if(c>=0 && heavier(mx[c], mx[x])) mx[x] = mx[c];
+    }
+    void push(int x){
+        if(!rev[x]) return;
+        swap(ch[x][0], ch[x][1]);
+        for(int c: ch[x]) if(c>=0) rev[c] ^= 1;
+        rev[x] = 0;
+    }
+    void rotate(int x){
+        int p = par[x], g = par[p];
+        int d = ch[p][1]==x;
+        if(!is_root(p)) ch[g][ch[g][1]==p] = x;
+        par[x] = g;
+        ch[p][d] = ch[x][d^1];
+        if(ch[p][d]>=0) par[ch[p][d]] = p;
+        ch[x][d^1] = p; par[p] = x;
+        pull(p); pull(x);
+    }
+    void splay(int x){
+        static vector<int> stk;
+        stk.clear(); stk.push_back(x);
+        for(int y=x; !is_root(y); y=par[y]) stk.push_back(par[y]);
+        for(int i=stk.size()-1;i>=0;--i) push(stk[i]);
+        while(!is_root(x)){
+            int p = par[x], g = par[p];
+            if(!is_root(p)) rotate((ch[g][1]==p) == (ch[p][1]==x) ? p : x);
+            rotate(x);
+        }
+    }
+    void access(int x){
+        for(int last=-1, y=x; y>=0; last=y, y=par[y]){ splay(y); ch[y][1] = last; pull(y); }
+        splay(x);
+    }
+    void make_root(int x){ access(x); rev[x] ^= 1; }
+    int find_root(int x){
+        access(x);
+        for(push(x); ch[x][0]>=0; push(x)) x = ch[x][0];
+        splay(x);
+        return x;
+    }
+    bool connected(int a, int b){ return a==b || find_root(a)==find_root(b); }
+    void link(int a, int b){ make_root(a); par[a] = b; }
+    void cut(int a, int b){
+        make_root(a); access(b);
+        if(ch[b][0]==a){ ch[b][0] = -1; par[a] = -1; pull(b); }
+    }
+    int path_max(int a, int b){ make_root(a); access(b); return mx[b]; }
+};
+
+struct DynamicMST {
+    LinkCutTree lct;
+    const vector<Edge> *E = nullptr;
+    vector<int> vnode, enode, treePos, treeList, mark;
+    vector<vector<int>> treeAdj;
+    vector<vector<pair<double,int>>> spare;
+    int stamp = 0;
+    double total = 0.0;
+    int vertex(int v){
+        if(v >= (int)vnode.size()){ vnode.resize(v+1, -1); treeAdj.resize(v+1); spare.resize(v+1); mark.resize(v+1, 0); }
+        if(vnode[v] < 0) vnode[v] = lct.add(-numeric_limits<double>::infinity(), -1);
+        return vnode[v];
+    }
+    bool in_tree(int id) const { return id < (int)treePos.size() && treePos[id] >= 0; }
+    void add_spare(int id){
+        auto &e = (*E)[id];
+        for(int x: {e.u, e.v}){
+            auto &lst = spare[x];
+            lst.insert(lower_bound(lst.begin(), lst.end(), make_pair(e.w, id)), {e.w, id});
+            if(e.u == e.v) break;
+        }
+    }
+    void drop_spare(int id){
+        auto &e = (*E)[id];
+        for(int x: {e.u, e.v}){
+            auto &lst = spare[x];
+            auto it = lower_bound(lst.begin(), lst.end(), make_pair(e.w, id));
+            if(it != lst.end() && it->second == id) lst.erase(it);
+        }
+    }
+    void attach(int id){
+        auto &e = (*E)[id];
+        if(enode[id] < 0) enode[id] = lct.add(e.w, e.id);
+        lct.link(enode[id], vertex(e.u));
+        lct.link(enode[id], vertex(e.v));
+        treeAdj[e.u].push_back(id); treeAdj[e.v].push_back(id);
+        treePos[id] = treeList.size(); treeList.push_back(id);
+        total += e.w;
+    }
+    void detach(int id){
+        auto &e = (*E)[id];
+        lct.cut(enode[id], vertex(e.u));
+        lct.cut(enode[id], vertex(e.v));
+        for(int x: {e.u, e.v}){ auto &lst = treeAdj[x]; *find(lst.begin(), lst.end(), id) = lst.back(); lst.pop_back(); }
+        int last = treeList.back();
+        treeList[treePos[id]] = last; treePos[last] = treePos[id];
+        treeList.pop_back(); treePos[id] = -1;
+        total -= e.w;
+    }
+    void init(int n, const vector<Edge> &edges, const vector<char> &removed, const vector<Edge> &mst){
+        lct = LinkCutTree();
+        E = &edges;
+        vnode.clear(); treeAdj.clear(); spare.clear(); mark.clear();
+        enode.assign(edges.size(), -1);
+        treePos.assign(edges.size(), -1);
+        treeList.clear(); total = 0.0; stamp = 0;
+        for(int v=0; v<n; ++v) vertex(v);
+        for(auto &e: mst) attach(e.id);
+        for(int v=0; v<n; ++v) spare[v].clear();
+        for(size_t i=0;i<edges.size();++i){
+            if(removed[i] || treePos[i] >= 0) continue;
+            spare[edges[i].u].push_back({edges[i].w, (int)i});
+            if(edges[i].u != edges[i].v) spare[edges[i].v].push_back({edges[i].w, (int)i});
+        }
+        for(auto &lst: spare) sort(lst.begin(), lst.end());
+    }
+    bool insert(int id){
+        enode.resize(E->size(), -1); treePos.resize(E->size(), -1);
+        auto &e = (*E)[id];
+        int a = vertex(e.u), b = vertex(e.v);
+        if(e.u == e.v){ add_spare(id); return false; }
+        if(lct.connected(a, b)){
+            int f = lct.tag[lct.path_max(a, b)];
+            if(!(e.w < (*E)[f].w || (e.w == (*E)[f].w && e.id < (*E)[f].id))){ add_spare(id); return false; }
+            detach(f);
+            add_spare(f);
+        }
+        attach(id);
+        return true;
+    }
+    vector<int> smaller_side(int a, int b){
+        if(++stamp == INT_MAX){ fill(mark.begin(), mark.end(), 0); stamp = 1; }
+        vector<int> side[2] = {{a}, {b}};
+        size_t head[2] = {0, 0};
+        mark[a] = stamp; mark[b] = -stamp;
+        for(int turn=0;; turn^=1){
+            if(head[turn] == side[turn].size()) break;
+            int x = side[turn][head[turn]++];
+            int tagv = turn ? -stamp : stamp;
+            for(int id: treeAdj[x]){
+                int y = (*E)[id].u == x ? (*E)[id].v : (*E)[id].u;
+                if(mark[y] != tagv){ mark[y] = tagv; side[turn].push_back(y); }
+            }
+        }
+        int small = head[0] == side[0].size() ? 0 : 1;
+        if(small == 1) for(int x: side[1]) mark[x] = stamp;
+        for(int x: side[small^1]) mark[x] = 0;
+        return side[small];
+    }
+    int erase(int id){
+        if(!in_tree(id)){ drop_spare(id); return -1; }
+        detach(id);
+        auto side = smaller_side((*E)[id].u, (*E)[id].v);
+        int best = -1;
+        for(int x: side){
+            for(auto &pr: spare[x]){
+                auto &f = (*E)[pr.second];
+                int y = f.u == x ? f.v : f.u;
+                if(mark[y] == stamp) continue;
+                if(best < 0 || pr.first < (*E)[best].w || (pr.first == (*E)[best].w && f.id < (*E)[best].id)) best = pr.second;
+                break;
+            }
+        }
+        if(best < 0) return -1;
+        drop_spare(best);
+        attach(best);
+        return best;
+    }
+    vector<Edge> tree_edges() const {
+        vector<Edge> out;
+        for(int id: treeList) out.push_back((*E)[id]);
+        sort(out.begin(), out.end(), [](const Edge &a, const Edge &b){ if(a.w==b.w) return a.id < b.id; return a.w < b.w; });
+        return out;
     }
 };
 
@@ -252,6 +735,33 @@ struct IOHelper {
         for(auto &p: comps) out<<p.first<<","<<p.second<<"\n";
         out.close();
     }
+    static void write_trees_csv(const string &path, const vector<Edge> &edges, const vector<SpanningTree> &trees){
+        ofstream out(path);
+        out<<"tree,cost,u,v,w,id\n";
+        for(size_t i=0;i<trees.size();++i)
+            for(int idx: trees[i].edges){ auto &e = edges[idx]; out<<i<<","<<trees[i].cost<<","<<e.u<<","<<e.v<<","<<e.w<<","<<e.id<<"\n"; }
+        out.close();
+    }
+    static vector<pair<int,int>> read_pairs_csv(const string &path){
+        vector<pair<int,int>> out;
+        ifstream in(path);
+        string line;
+        while(getline(in, line)){
+            size_t c = line.find(',');
+            if(c == string::npos) continue;
+            char *e1, *e2;
+            long a = strtol(line.c_str(), &e1, 10), b = strtol(line.c_str()+c+1, &e2, 10);
+            if(e1 != line.c_str()+c || e2 == line.c_str()+c+1) continue;
+            out.push_back({(int)a, (int)b});
+        }
+        return out;
+    }
+    static void write_labels_csv(const string &path, const vector<int> &labels){
+        ofstream out(path);
+        out<<"node,component_id\n";
+        for(size_t i=0;i<labels.size();++i) out<<i<<","<<labels[i]<<"\n";
+        out.close();
+    }
     static void write_edges_csv(const string &path, const vector<Edge> &edges){
         ofstream out(path);
         out<<"u,v,w,id\n";
@@ -277,20 +787,69 @@ struct Simulator {
     vector<Edge> mst;
     vector<vector<pair<int,double>>> adj_mst;
     vector<vector<pair<int,double>>> adj_full;
+    ClusterTree clusters;
+    TreeOracle oracle;
+    DynamicMST dyn;
     ShortestPath sp;
-    Simulator(){}
-    void init(const string &edges_csv){
+    MstBackend backend;
+    int threads;
+    bool dirty;
+    Simulator():backend(MstBackend::Kruskal),threads(max(1u,thread::hardware_concurrency())),dirty(false){}
+    void init(const string &edges_csv, MstBackend backend_=MstBackend::Kruskal, int threads_=0){
+        backend = backend_;
+        if(threads_>0) threads = threads_;
         solver.load_from_csv(edges_csv);
-        auto tmp = solver.mst_kruskal();
+        refresh();
+    }
+    double rebuild_mst(){
+        auto tmp = solver.mst_with(backend, threads);
         mst = tmp.first;
+        dyn.init(solver.n, solver.edges, solver.removed, mst);
+        dirty = false;
         adj_mst = solver.build_adj_from_mst(mst);
-        adj_full = solver.build_adj_full();
-        sp.build_from_adj(adj_full);
+        clusters.build(solver.n, mst);
+        oracle.build(adj_mst);
+        return tmp.second;
     }
-    void refresh(){
-        auto tmp = solver.mst_kruskal();
-        mst = tmp.first;
+    void sync(){
+        if(!dirty) return;
+        mst = dyn.tree_edges();
         adj_mst = solver.build_adj_from_mst(mst);
+        clusters.build(solver.n, mst);
+        oracle.build(adj_mst);
+        dirty = false;
+    }
+    int add_link(int u, int v, double w){
+        int id = solver.edges.size();
+        solver.edges.emplace_back(u, v, w, id);
+        solver.removed.push_back(0);
+        solver.n = max(solver.n, max(u, v) + 1);
+        for(auto *adj: {&adj_full, &sp.adj}){
+            if((int)adj->size() < solver.n) adj->resize(solver.n);
+            (*adj)[u].push_back({v, w});
+            (*adj)[v].push_back({u, w});
+        }
+        sp.n = sp.adj.size();
+        if(dyn.insert(id)) dirty = true;
+        return id;
+    }
+    int remove_link(int id){
+        auto &e = solver.edges[id];
+        solver.removed[id] = 1;
+        for(auto *adj: {&adj_full, &sp.adj}){
+            for(auto ends: {make_pair(e.u, e.v), make_pair(e.v, e.u)}){
+                auto &lst = (*adj)[ends.first];
+                auto it = find(lst.begin(), lst.end(), make_pair(ends.second, e.w));
+                if(it != lst.end()) lst.erase(it);
+            }
+        }
+        bool wasTree = dyn.in_tree(id);
+        int rep = dyn.erase(id);
+        if(wasTree) dirty = true;
+        return rep;
+    }
+    void refresh(){
+        rebuild_mst();
         adj_full = solver.build_adj_full();
         sp.build_from_adj(adj_full);
     }
@@ -312,6 +871,33 @@ struct Simulator {
         }
         out.close();
     }
+    long long run_tree_batch(const vector<pair<int,int>> &pairs, const string &outcsv, bool withPath){
+        ofstream out(outcsv);
+        out<<"s,t,cost,path\n";
+        string buf;
+        char num[64];
+        long long reached = 0;
+        for(auto &pr: pairs){
+            int s = pr.first; int t = pr.second;
+            buf += to_string(s); buf += ','; buf += to_string(t); buf += ',';
+            double d = oracle.distance(s, t);
+            if(d < 1e17){
+                ++reached;
+                snprintf(num, sizeof(num), "%g", d);
+                buf += num;
+                buf += ",\"";
+                if(withPath){
+                    auto path = oracle.path(s, t);
+                    for(size_t i=0;i<path.size();++i){ if(i) buf += '-'; buf += to_string(path[i]); }
+                }
+                buf += "\"\n";
+            } else buf += "INF,\n";
+            if(buf.size() > (1u<<20)){ out.write(buf.data(), buf.size()); buf.clear(); }
+        }
+        out.write(buf.data(), buf.size());
+        out.close();
+        return reached;
+    }
     vector<pair<int,double>> nearest_k_from(int s, int k){
         auto res = sp.dijkstra(s);
         auto &dist = res.first;
@@ -342,16 +928,19 @@ struct Simulator {
                 auto p = generate_random_pairs(50);
                 run_routing_batch(p, "/tmp/kruskal_batch.csv");
             } else if(t==1){
-                solver.edges.insert(solver.edges.end(), {0,0, (double)(dd(rng)%100), (int)solver.edges.size()});
-                refresh();
+                int n = max(1, solver.n);
+                int id = (int)(rng()%max<size_t>(1, solver.edges.size()));
+                if(dd(rng)%2 && !solver.edges.empty() && !solver.removed[id]) remove_link(id);
+                else add_link(rng()%n, rng()%n, (double)(dd(rng)%100));
             } else if(t==2){
-                auto comps = solver.cluster_by_threshold(10.0);
+                sync();
+                auto comps = clusters.components_at(10.0);
                 IOHelper::write_components_csv("/tmp/components.csv", comps);
             } else {
                 auto nn = nearest_k_from(0, 5);
             }
-            if(i%50==0) refresh();
         }
+        sync();
     }
 };
 
@@ -359,14 +948,17 @@ int main(int argc,char**argv){
     ios::sync_with_stdio(false);
     cin.tie(nullptr);
     if(argc < 2){
-        cerr<<"Usage: "<<argv[0]<<" <edges-csv>\n";
+        cerr<<"Usage: "<<argv[0]<<" <edges-csv> [kruskal|filter] [threads]\n";
         return 1;
     }
     string csv = argv[1];
+    MstBackend backend = MstBackend::Kruskal;
+    if(argc > 2 && !parse_mst_backend(argv[2], backend)){ cerr<<"unknown mst backend "<<argv[2]<<"\n"; return 1; }
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
     Simulator sim;
-    Bench::time_fn([&](){ sim.init(csv); }, "init");
-    cout<<"Nodes="<<sim.solver.n<<" Edges="<<sim.solver.edges.size()<<"\n";
-    cout<<"Commands:\nshowmst\nwritemst out.csv\ncomponents thresh\ncluster thresh\nkshort k\nroute s t\nbatch n out.csv\nnearest s k\nstress n\nexport edges out.csv\nexit\n";
+    Bench::time_fn([&](){ sim.init(csv, backend, threads); }, "init");
+    cout<<"Nodes="<<sim.solver.n<<" Edges="<<sim.solver.edges.size()<<" mst="<<mst_backend_name(sim.backend)<<" threads="<<sim.threads<<"\n";
+    cout<<"Commands:\nmst [kruskal|filter] [threads]\naddedge u v w\ndeledge id\nshowmst\nwritemst out.csv\ncomponents thresh\ncluster thresh\nsweep out.csv t1 t2 ...\nkshort k\nroute s t\ntreeroute s t\nbatch n out.csv\ntreebatch n|pairs.csv out.csv [nopath]\nnearest s k\nstress n\nexport edges out.csv\nexit\n";
     string line;
     while(true){
         cout<<"> ";
@@ -376,6 +968,39 @@ int main(int argc,char**argv){
         if(parts.empty()) continue;
         string cmd = parts[0];
         if(cmd=="exit" || cmd=="quit") break;
+        if(cmd=="addedge"){
+            if(parts.size()<4){ cout<<"addedge u v w\n"; continue; }
+            int u = stoi(parts[1]), v = stoi(parts[2]);
+            if(u<0 || v<0){ cout<<"invalid\n"; continue; }
+            auto t0 = chrono::steady_clock::now();
+            int id = sim.add_link(u, v, stod(parts[3]));
+            auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now()-t0).count();
+            cout<<"edge id="<<id<<(sim.dyn.in_tree(id) ? " tree" : " nontree")<<" mst_total="<<sim.dyn.total<<" in "<<us<<" us\n";
+            continue;
+        }
+        if(cmd=="deledge"){
+            if(parts.size()<2){ cout<<"deledge id\n"; continue; }
+            int id = stoi(parts[1]);
+            if(id<0 || id>=(int)sim.solver.edges.size() || sim.solver.removed[id]){ cout<<"invalid\n"; continue; }
+            bool wasTree = sim.dyn.in_tree(id);
+            auto t0 = chrono::steady_clock::now();
+            int rep = sim.remove_link(id);
+            auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now()-t0).count();
+            cout<<"removed id="<<id<<(wasTree ? " tree" : " nontree");
+            if(wasTree){ if(rep>=0) cout<<" replacement="<<rep; else cout<<" replacement=none"; }
+            cout<<" mst_total="<<sim.dyn.total<<" in "<<us<<" us\n";
+            continue;
+        }
+        sim.sync();
+        if(cmd=="mst"){
+            if(parts.size()>=2 && !parse_mst_backend(parts[1], sim.backend)){ cout<<"mst [kruskal|filter] [threads]\n"; continue; }
+            if(parts.size()>=3) sim.threads = max(1, stoi(parts[2]));
+            long long t0 = Bench::now_ms();
+            double total = sim.rebuild_mst();
+            long long t1 = Bench::now_ms();
+            cout<<"mst="<<mst_backend_name(sim.backend)<<" threads="<<sim.threads<<" edges="<<sim.mst.size()<<" total="<<total<<" in "<<(t1-t0)<<" ms\n";
+            continue;
+        }
         if(cmd=="showmst"){
             for(auto &e: sim.mst) cout<<e.u<<","<<e.v<<","<<e.w<<","<<e.id<<"\n";
             continue;
@@ -389,24 +1014,45 @@ int main(int argc,char**argv){
         if(cmd=="components"){
             if(parts.size()<2){ cout<<"components thresh\n"; continue; }
             double thr = stod(parts[1]);
-            auto comps = sim.solver.cluster_by_threshold(thr);
+            auto comps = sim.clusters.components_at(thr);
             for(auto &c: comps) cout<<c.first<<","<<c.second<<"\n";
             continue;
         }
         if(cmd=="cluster"){
             if(parts.size()<2){ cout<<"cluster thresh\n"; continue; }
             double thr = stod(parts[1]);
-            auto comps = sim.solver.cluster_by_threshold(thr);
+            auto comps = sim.clusters.components_at(thr);
             IOHelper::write_components_csv("components.csv", comps);
-            cout<<"wrote components.csv\n";
+            IOHelper::write_labels_csv("cluster_labels.csv", sim.clusters.labels_at(thr));
+            cout<<"wrote components.csv cluster_labels.csv count="<<comps.size()<<"\n";
+            continue;
+        }
+        if(cmd=="sweep"){
+            if(parts.size()<3){ cout<<"sweep out.csv t1 t2 ...\n"; continue; }
+            vector<double> ts;
+            for(size_t i=2;i<parts.size();++i) ts.push_back(stod(parts[i]));
+            ofstream out(parts[1]);
+            out<<"threshold,component_id,size\n";
+            cout<<"threshold,components,largest\n";
+            for(double t: ts){
+                auto comps = sim.clusters.components_at(t);
+                int largest = 0;
+                for(auto &c: comps){ out<<t<<","<<c.first<<","<<c.second<<"\n"; largest = max(largest, c.second); }
+                cout<<t<<","<<comps.size()<<","<<largest<<"\n";
+            }
+            cout<<"wrote "<<parts[1]<<"\n";
             continue;
         }
         if(cmd=="kshort"){
             if(parts.size()<2){ cout<<"kshort k\n"; continue; }
             int k = stoi(parts[1]);
-            auto v = sim.solver.k_shortest_mst_variants(k);
-            IOHelper::write_edges_csv("kshort_edges.csv", v);
-            cout<<"wrote kshort_edges.csv count="<<v.size()<<"\n";
+            long long t0 = Bench::now_ms();
+            auto trees = sim.solver.k_best_spanning_trees(k);
+            long long t1 = Bench::now_ms();
+            IOHelper::write_trees_csv("kshort_edges.csv", sim.solver.edges, trees);
+            for(size_t i=0;i<trees.size() && i<20;++i) cout<<i<<","<<trees[i].cost<<"\n";
+            if(trees.size() > 20) cout<<"... "<<trees.size()-20<<" more\n";
+            cout<<"wrote kshort_edges.csv trees="<<trees.size()<<" in "<<(t1-t0)<<" ms\n";
             continue;
         }
         if(cmd=="route"){
@@ -421,6 +1067,28 @@ int main(int argc,char**argv){
             cout<<"\n";
             continue;
         }
+        if(cmd=="treeroute"){
+            if(parts.size()<3){ cout<<"treeroute s t\n"; continue; }
+            int s = stoi(parts[1]); int t = stoi(parts[2]);
+            double d = sim.oracle.distance(s, t);
+            if(d > 1e17){ cout<<"unreachable\n"; continue; }
+            auto path = sim.oracle.path(s, t);
+            cout<<"cost="<<d<<" path:";
+            for(size_t i=0;i<path.size(); ++i){ if(i) cout<<"-"; cout<<path[i]; }
+            cout<<"\n";
+            continue;
+        }
+        if(cmd=="treebatch"){
+            if(parts.size()<3){ cout<<"treebatch n|pairs.csv out.csv [nopath]\n"; continue; }
+            bool isCount = all_of(parts[1].begin(), parts[1].end(), [](char c){ return isdigit((unsigned char)c); });
+            auto pairs = isCount ? sim.generate_random_pairs(stoi(parts[1])) : IOHelper::read_pairs_csv(parts[1]);
+            bool withPath = !(parts.size()>3 && parts[3]=="nopath");
+            long long t0 = Bench::now_ms();
+            long long reached = sim.run_tree_batch(pairs, parts[2], withPath);
+            long long ms = max(1LL, Bench::now_ms()-t0);
+            cout<<"wrote "<<parts[2]<<" pairs="<<pairs.size()<<" reachable="<<reached<<" in "<<ms<<" ms ("<<(long long)(pairs.size()*1000.0/ms)<<" pairs/sec)\n";
+            continue;
+        }
         if(cmd=="batch"){
             if(parts.size()<3){ cout<<"batch n out.csv\n"; continue; }
             int n = stoi(parts[1]);
@@ -446,7 +1114,12 @@ int main(int argc,char**argv){
         }
         if(cmd=="export"){
             if(parts.size()<3){ cout<<"export edges out.csv\n"; continue; }
-            if(parts[1]=="edges"){ IOHelper::write_edges_csv(parts[2], sim.solver.edges); cout<<"wrote "<<parts[2]<<"\n"; }
+            if(parts[1]=="edges"){
+                vector<Edge> live;
+                for(auto &e: sim.solver.edges) if(!sim.solver.removed[e.id]) live.push_back(e);
+                IOHelper::write_edges_csv(parts[2], live);
+                cout<<"wrote "<<parts[2]<<"\n";
+            }
             else cout<<"unknown export\n";
             continue;
         }
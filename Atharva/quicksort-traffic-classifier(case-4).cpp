@@ -10,41 +10,250 @@ struct Record {
     int index;
 };
 
-static vector<vector<string>> read_csv_rows(const string &path){
+static vector<string> split_csv_line(const string &line){
+    vector<string> cols;
+    string cur; bool inq=false;
+    for(char c: line){
+        if(c=='"'){ inq = !inq; continue; }
+        if(c==',' && !inq){ cols.push_back(cur); cur.clear(); } else cur.push_back(c);
+    }
+    cols.push_back(cur);
+    return cols;
+}
+
+static int64_t days_from_civil(int64_t y, int m, int d){
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+struct TimeStyle {
+    bool numeric = false;
+    bool time = true;
+    char sep = 'T';
+    bool seconds = true;
+    int frac = 0;
+    int offsetMin = 0;
+    string zone;
+    bool operator==(const TimeStyle &o) const {
+        return numeric == o.numeric && time == o.time && sep == o.sep && seconds == o.seconds && frac == o.frac && offsetMin == o.offsetMin && zone == o.zone;
+    }
+};
+
+static bool parse_timestamp(const string &s, int64_t &ms, TimeStyle &st){
+    const char *p = s.c_str();
+    auto digits = [&](int lo, int hi, long long &v){
+        int k = 0; v = 0;
+        while(k < hi && isdigit((unsigned char)p[k])){ v = v*10 + (p[k]-'0'); ++k; }
+        if(k < lo) return false;
+        p += k; return true;
+    };
+    auto fraction = [&](int &len){
+        long long f = 0; len = 0;
+        if(*p != '.') return 0LL;
+        ++p;
+        while(isdigit((unsigned char)*p)){ if(len < 3){ f = f*10 + (*p-'0'); } ++len; ++p; }
+        for(int k=min(len,3);k<3;++k) f *= 10;
+        return f;
+    };
+    TimeStyle out;
+    long long y, mo, d, h = 0, mi = 0, se = 0;
+    bool neg = *p == '-';
+    if(neg) ++p;
+    if(!digits(1, 18, y)) return false;
+    if(*p != '-' || neg){
+        if(*p && *p != '.') return false;
+        out.numeric = true;
+        long long f = fraction(out.frac);
+        if(*p || (out.frac == 0 && p[-1] == '.')) return false;
+        ms = (neg ? -1 : 1) * (y * 1000 + f);
+        st = out;
+        return true;
+    }
+    ++p;
+    if(!digits(1, 2, mo) || *p++ != '-' || !digits(1, 2, d) || mo < 1 || mo > 12 || d < 1) return false;
+    static const int mdays[12] = {31,29,31,30,31,30,31,31,30,31,30,31};
+    bool leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+    if(d > mdays[mo-1] || (mo == 2 && d == 29 && !leap)) return false;
+    long long f = 0;
+    if(*p == 'T' || *p == ' '){
+        out.sep = *p++;
+        if(!digits(2, 2, h) || *p++ != ':' || !digits(2, 2, mi) || h > 23 || mi > 59) return false;
+        out.seconds = *p == ':';
+        if(out.seconds){ ++p; if(!digits(2, 2, se) || se > 60) return false; f = fraction(out.frac); }
+    } else out.time = false;
+    if(*p == 'Z'){ out.zone = "Z"; ++p; }
+    else if(*p == '+' || *p == '-'){
+        const char *z = p;
+        int sign = *p++ == '-' ? -1 : 1;
+        long long oh, om = 0;
+        if(!digits(2, 2, oh)) return false;
+        if(*p == ':') ++p;
+        if(!digits(2, 2, om)) return false;
+        out.offsetMin = sign * (int)(oh*60 + om);
+        out.zone.assign(z, p);
+    }
+    if(*p) return false;
+    ms = ((days_from_civil(y, (int)mo, (int)d) * 86400 + h * 3600 + mi * 60 + se) - out.offsetMin * 60LL) * 1000 + f;
+    st = out;
+    return true;
+}
+
+static string format_timestamp(int64_t ms, const TimeStyle &st){
+    auto frac = [&](int64_t sub){
+        if(st.frac <= 0) return string();
+        int k = min(st.frac, 3);
+        char buf[8];
+        snprintf(buf, sizeof buf, ".%0*d", k, (int)(sub / (k == 1 ? 100 : k == 2 ? 10 : 1)));
+        return string(buf);
+    };
+    if(st.numeric){
+        uint64_t a = ms < 0 ? -(uint64_t)ms : (uint64_t)ms;
+        return (ms < 0 ? "-" : "") + to_string(a / 1000) + frac(a % 1000);
+    }
+    int64_t sub = ms % 1000, epoch = ms / 1000;
+    if(sub < 0){ sub += 1000; --epoch; }
+    epoch += st.offsetMin * 60LL;
+    int64_t days = epoch / 86400, secs = epoch % 86400;
+    if(secs < 0){ secs += 86400; --days; }
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    int64_t doy = doe - (365*yoe + yoe/4 - yoe/100);
+    int64_t mp = (5*doy + 2) / 153;
+    int d = (int)(doy - (153*mp + 2)/5 + 1), m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    int64_t y = yoe + era * 400 + (m <= 2);
+    char buf[64];
+    int len = snprintf(buf, sizeof buf, "%04lld-%02d-%02d", (long long)y, m, d);
+    if(st.time) len += snprintf(buf + len, sizeof buf - len, "%c%02d:%02d", st.sep, (int)(secs/3600), (int)(secs/60%60));
+    if(st.time && st.seconds) snprintf(buf + len, sizeof buf - len, ":%02d", (int)(secs%60));
+    return buf + frac(sub) + st.zone;
+}
+
+struct TrafficTable {
+    vector<int64_t> ts;
+    vector<int32_t> loc, drones, vehicles;
+    vector<double> density;
+    vector<TimeStyle> tsStyles;
+    vector<uint8_t> tsStyleOf;
+    unordered_map<int, string> tsRaw;
+    vector<int32_t> locIds;
+    vector<int> locStart, locRows;
+
+    int size() const { return (int)density.size(); }
+    int groups() const { return (int)locIds.size(); }
+    int group_of(int id) const {
+        auto it = lower_bound(locIds.begin(), locIds.end(), id);
+        return it != locIds.end() && *it == id ? (int)(it - locIds.begin()) : -1;
+    }
+    int group_size(int g) const { return locStart[g+1] - locStart[g]; }
+    const int *group_rows(int g) const { return locRows.data() + locStart[g]; }
+
+    void push(const string &t, int l, int dr, int veh, double d){
+        push_timestamp(t); loc.push_back(l); drones.push_back(dr); vehicles.push_back(veh); density.push_back(d);
+    }
+
+    void build_groups(){
+        int n = size();
+        locIds.clear(); locStart.assign(1, 0); locRows.assign(n, 0);
+        if(n == 0) return;
+        auto mm = minmax_element(loc.begin(), loc.end());
+        int64_t lo = *mm.first, span = (int64_t)*mm.second - lo + 1;
+        vector<int> slot(n);
+        if(span <= (int64_t)n + 65536){
+            vector<int> cnt(span, 0);
+            for(int i=0;i<n;++i) ++cnt[loc[i] - lo];
+            vector<int> id(span, -1);
+            for(int64_t v=0;v<span;++v) if(cnt[v]){ id[v] = locIds.size(); locIds.push_back((int32_t)(v + lo)); }
+            for(int i=0;i<n;++i) slot[i] = id[loc[i] - lo];
+        } else {
+            locIds = loc;
+            sort(locIds.begin(), locIds.end());
+            locIds.erase(unique(locIds.begin(), locIds.end()), locIds.end());
+            for(int i=0;i<n;++i) slot[i] = group_of(loc[i]);
+        }
+        int g = groups();
+        locStart.assign(g+1, 0);
+        for(int i=0;i<n;++i) ++locStart[slot[i]+1];
+        for(int k=0;k<g;++k) locStart[k+1] += locStart[k];
+        vector<int> pos(locStart.begin(), locStart.end()-1);
+        for(int i=0;i<n;++i) locRows[pos[slot[i]]++] = i;
+    }
+
+    string timestamp(int i) const {
+        auto it = tsRaw.find(i);
+        return it != tsRaw.end() ? it->second : format_timestamp(ts[i], tsStyles[tsStyleOf[i]]);
+    }
+
+    void push_timestamp(const string &text){
+        int64_t ms = 0; TimeStyle st;
+        bool ok = parse_timestamp(text, ms, st);
+        size_t k = 0;
+        if(ok){
+            k = find(tsStyles.begin(), tsStyles.end(), st) - tsStyles.begin();
+            if(k == tsStyles.size() && k < 255) tsStyles.push_back(st);
+            ok = k < tsStyles.size() && format_timestamp(ms, tsStyles[k]) == text;
+        }
+        if(!ok){ tsRaw.emplace((int)ts.size(), text); k = 0; }
+        tsStyleOf.push_back((uint8_t)k);
+        ts.push_back(ms);
+    }
+
+    Record row(int i) const { return {timestamp(i), loc[i], drones[i], vehicles[i], density[i], i}; }
+
+    vector<Record> records() const {
+        vector<Record> out; out.reserve(size());
+        for(int i=0;i<size();++i) out.push_back(row(i));
+        return out;
+    }
+};
+
+struct TrafficSchema {
+    int col[5] = {0, 1, 2, 3, 4};
+    int need = 5;
+    void from_header(const string &line){
+        auto header = split_csv_line(line);
+        const char *names[5] = {"timestamp", "location_id", "drone_count", "vehicle_count", "density"};
+        if(find(header.begin(), header.end(), "density") != header.end())
+            for(int k=0;k<5;++k){
+                auto it = find(header.begin(), header.end(), names[k]);
+                col[k] = it == header.end() ? -1 : (int)(it - header.begin());
+            }
+        need = *max_element(col, col+5) + 1;
+    }
+    bool parse(string line, string &timestamp, int &loc, int &drones, int &vehicles, double &density) const {
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        auto r = split_csv_line(line);
+        if((int)r.size() < need) return false;
+        timestamp = col[0] >= 0 ? r[col[0]] : string();
+        try {
+            auto num = [&](int k){ return col[k] < 0 ? 0 : stoi(r[col[k]]); };
+            loc = num(1); drones = num(2); vehicles = num(3);
+            density = stod(r[col[4]]);
+        } catch(const exception &){ return false; }
+        return true;
+    }
+};
+
+static TrafficTable load_table(const string &path){
+    TrafficTable t;
     ifstream in(path);
-    vector<vector<string>> rows;
-    if(!in.is_open()) return rows;
     string line;
-    if(!getline(in,line)) return rows;
+    if(!in.is_open() || !getline(in,line)) return t;
+    TrafficSchema schema;
+    schema.from_header(line);
+    string stamp;
     while(getline(in,line)){
-        vector<string> cols;
-        string cur; bool inq=false;
-        for(char c: line){
-            if(c=='"'){ inq = !inq; continue; }
-            if(c==',' && !inq){ cols.push_back(cur); cur.clear(); } else cur.push_back(c);
-        }
-        cols.push_back(cur);
-        rows.push_back(cols);
-    }
-    return rows;
-}
-
-static vector<Record> load_records(const string &path){
-    auto rows = read_csv_rows(path);
-    vector<Record> out; out.reserve(rows.size());
-    int idx=0;
-    for(auto &r: rows){
-        if(r.size() < 5) continue;
-        Record rec;
-        rec.timestamp = r[0];
-        rec.location_id = stoi(r[1]);
-        rec.drone_count = stoi(r[2]);
-        rec.vehicle_count = stoi(r[3]);
-        rec.density = stod(r[4]);
-        rec.index = idx++;
-        out.push_back(rec);
+        int loc, dr, veh; double d;
+        if(!schema.parse(line, stamp, loc, dr, veh, d)) continue;
+        t.push(stamp, loc, dr, veh, d);
     }
-    return out;
+    t.build_groups();
+    return t;
 }
 
 struct Timer {
@@ -116,13 +325,37 @@ struct Fenwick {
     double range(int l,int r){ if(r<l) return 0.0; return sum(r) - (l?sum(l-1):0.0); }
 };
 
-struct SlidingWindow {
-    deque<double> dq;
-    double sum = 0.0;
-    void push(double v){ dq.push_back(v); sum += v; }
-    void pop(){ if(!dq.empty()){ sum -= dq.front(); dq.pop_front(); } }
-    double mean() const { if(dq.empty()) return 0.0; return sum / (double)dq.size(); }
-    int size() const { return (int)dq.size(); }
+struct RollingStats {
+    vector<double> buf;
+    int head = 0, cnt = 0;
+    double mean = 0, m2 = 0;
+    RollingStats(int window = 1): buf(max(1, window)) {}
+    void push(double v){
+        int cap = buf.size();
+        if(cnt < cap){
+            buf[(head + cnt) % cap] = v; ++cnt;
+            double d = v - mean;
+            mean += d / cnt;
+            m2 += d * (v - mean);
+            return;
+        }
+        double old = buf[head];
+        buf[head] = v;
+        head = (head + 1) % cap;
+        double nm = mean + (v - old) / cnt;
+        m2 += (v - old) * (v - nm + old - mean);
+        mean = nm;
+        if(head == 0) resync();
+        else if(m2 < 0) m2 = 0;
+    }
+    void resync(){
+        double s = 0;
+        for(double x: buf) s += x;
+        mean = s / cnt; m2 = 0;
+        for(double x: buf){ double d = x - mean; m2 += d*d; }
+    }
+    int size() const { return cnt; }
+    double variance() const { return cnt ? m2 / cnt : 0.0; }
 };
 
 struct Anomaly {
@@ -131,95 +364,267 @@ struct Anomaly {
     double zscore;
 };
 
-static unordered_map<int, vector<Record>> group_by_location(const vector<Record> &rows){
-    unordered_map<int, vector<Record>> mp;
-    for(auto &r: rows) mp[r.location_id].push_back(r);
-    return mp;
-}
-
-static unordered_map<int, Fenwick> build_fenwicks(const unordered_map<int, vector<Record>> &mp){
-    unordered_map<int, Fenwick> ret;
-    for(auto &kv: mp){
-        int loc = kv.first;
-        int m = (int)kv.second.size();
-        Fenwick f(m);
-        for(int i=0;i<m;++i) f.add(i, kv.second[i].density);
-        ret[loc] = move(f);
+static vector<Fenwick> build_fenwicks(const TrafficTable &t){
+    vector<Fenwick> ret(t.groups());
+    for(int g=0;g<t.groups();++g){
+        int m = t.group_size(g);
+        const int *rows = t.group_rows(g);
+        ret[g].init(m);
+        for(int i=0;i<m;++i) ret[g].add(i, t.density[rows[i]]);
     }
     return ret;
 }
 
-static vector<Anomaly> detect_anomalies_zscore(const vector<Record> &series, int window, double thresh){
+static bool zscore_step(RollingStats &rs, double v, double thresh, double &z){
+    rs.push(v);
+    if(rs.size() < 5) return false;
+    double sd = sqrt(rs.variance());
+    if(sd <= 1e-9) return false;
+    z = (v - rs.mean) / sd;
+    return fabs(z) >= thresh;
+}
+
+static vector<Anomaly> detect_anomalies_zscore(const TrafficTable &t, int g, int window, double thresh){
     vector<Anomaly> out;
-    SlidingWindow sw;
-    for(size_t i=0;i<series.size();++i){
-        double v = series[i].density;
-        sw.push(v);
-        if(sw.size() > window) sw.pop();
-        if(sw.size() < 5) continue;
-        int n = sw.size();
-        double mean = sw.mean();
-        double var = 0;
-        for(auto x: sw.dq) { double d = x - mean; var += d*d; }
-        var /= n;
-        double sd = sqrt(var);
-        if(sd <= 1e-9) continue;
-        double z = (v - mean) / sd;
-        if(fabs(z) >= thresh) out.push_back({(int)i, v, z});
+    RollingStats rs(window);
+    int m = t.group_size(g);
+    const int *rows = t.group_rows(g);
+    for(int i=0;i<m;++i){
+        double v = t.density[rows[i]], z;
+        if(zscore_step(rs, v, thresh, z)) out.push_back({i, v, z});
     }
     return out;
 }
 
-static vector<pair<int,int>> compute_tiers(const vector<Record> &sorted, double low_quantile=0.33, double high_quantile=0.66){
+static vector<vector<Anomaly>> detect_anomalies_all(const TrafficTable &t, int window, double thresh, int threads){
+    vector<vector<Anomaly>> out(t.groups());
+    atomic<int> next{0};
+    auto work = [&]{
+        for(int g; (g = next++) < t.groups(); ) out[g] = detect_anomalies_zscore(t, g, window, thresh);
+    };
+    vector<thread> th;
+    for(int i=1;i<threads;++i) th.emplace_back(work);
+    work();
+    for(auto &x: th) x.join();
+    return out;
+}
+
+static long long tail_anomalies(const string &path, int window, double thresh, int idleMs){
+    TrafficSchema schema;
+    unordered_map<int, pair<RollingStats,int>> streams;
+    streamoff offset = 0;
+    bool header = true;
+    long long rows = 0, hits = 0;
+    auto lastData = chrono::steady_clock::now();
+    while(chrono::steady_clock::now() - lastData < chrono::milliseconds(idleMs)){
+        ifstream in(path, ios::binary);
+        string buf;
+        if(in.is_open()){
+            in.seekg(0, ios::end);
+            streamoff size = in.tellg();
+            if(size < offset){ offset = 0; header = true; streams.clear(); }
+            if(size > offset){
+                buf.resize(size - offset);
+                in.seekg(offset);
+                in.read(&buf[0], buf.size());
+            }
+        }
+        size_t last = buf.rfind('\n');
+        if(last == string::npos){ this_thread::sleep_for(chrono::milliseconds(50)); continue; }
+        offset += last + 1;
+        lastData = chrono::steady_clock::now();
+        for(size_t pos = 0; pos <= last; ){
+            size_t nl = buf.find('\n', pos);
+            string line = buf.substr(pos, nl - pos);
+            pos = nl + 1;
+            if(header){ schema.from_header(line); header = false; continue; }
+            string stamp; int loc, dr, veh; double d, z;
+            if(!schema.parse(line, stamp, loc, dr, veh, d)) continue;
+            ++rows;
+            auto it = streams.try_emplace(loc, RollingStats(window), 0).first;
+            int idx = it->second.second++;
+            if(zscore_step(it->second.first, d, thresh, z)){ cout<<loc<<","<<idx<<","<<d<<","<<z<<"\n"; ++hits; }
+        }
+        cout.flush();
+    }
+    cout<<"tail: "<<rows<<" rows, "<<hits<<" anomalies, idle "<<idleMs<<" ms\n";
+    return hits;
+}
+
+static vector<pair<int,int>> compute_tiers(const vector<double> &density, const vector<int> &sorted, double low_quantile=0.33, double high_quantile=0.66){
     int n = (int)sorted.size();
     int low_idx = max(0, (int)floor(low_quantile * n) - 1);
     int high_idx = min(n-1, (int)floor(high_quantile * n) - 1);
-    double low_thr = sorted[low_idx].density;
-    double high_thr = sorted[high_idx].density;
+    double low_thr = density[sorted[low_idx]];
+    double high_thr = density[sorted[high_idx]];
     vector<pair<int,int>> tiers;
-    for(auto &r: sorted){
-        int tier = (r.density <= low_thr) ? 0 : (r.density <= high_thr ? 1 : 2);
-        tiers.push_back({r.index, tier});
+    tiers.reserve(n);
+    for(int i: sorted){
+        double d = density[i];
+        int tier = (d <= low_thr) ? 0 : (d <= high_thr ? 1 : 2);
+        tiers.push_back({i, tier});
     }
     return tiers;
 }
 
-static void ascii_histogram(const vector<Record> &rows, int buckets=40){
+static void print_buckets(const vector<long long> &cnt){
+    long long maxc = *max_element(cnt.begin(), cnt.end());
+    for(size_t i=0;i<cnt.size();++i){
+        int w = maxc? (int)(cnt[i]*50/maxc) : 0;
+        cout<<setw(3)<<i<<": "<<string(w,'#')<<" ("<<cnt[i]<<")\n";
+    }
+}
+
+static int bucket_of(double v, double mn, double mx, int buckets){
+    int bi = (int)((v - mn) / (mx - mn) * (buckets-1));
+    return max(0,min(buckets-1,bi));
+}
+
+static void ascii_histogram(const vector<double> &vals, int buckets=40){
     double mn = 1e18, mx = -1e18;
-    for(auto &r: rows){ mn = min(mn, r.density); mx = max(mx, r.density); }
+    for(double v: vals){ mn = min(mn, v); mx = max(mx, v); }
     if(mn >= mx){ cout<<"flat\n"; return; }
-    vector<int> cnt(buckets,0);
-    for(auto &r: rows){
-        int bi = (int)((r.density - mn) / (mx - mn) * (buckets-1));
-        bi = max(0,min(buckets-1,bi));
-        cnt[bi]++; 
-    }
-    int maxc = *max_element(cnt.begin(), cnt.end());
-    for(int i=0;i<buckets;++i){
-        int w = maxc? (cnt[i]*50/maxc) : 0;
-        cout<<setw(3)<<i<<": "<<string(w,'#')<<" ("<<cnt[i]<<")\n";
+    vector<long long> cnt(buckets,0);
+    for(double v: vals) cnt[bucket_of(v, mn, mx, buckets)]++;
+    print_buckets(cnt);
+}
+
+struct KLLSketch {
+    int k;
+    long long n = 0;
+    double mn = numeric_limits<double>::infinity(), mx = -numeric_limits<double>::infinity();
+    vector<vector<double>> levels;
+    size_t retained = 0, maxRetained = 0;
+    uint64_t rng;
+    KLLSketch(int k_ = 200, uint64_t seed = 1): k(max(8, k_)), rng(seed * 0x9E3779B97F4A7C15ULL + 1) { grow(); }
+    int capacity(int h) const { return max(2, (int)ceil(k * pow(2.0/3.0, (int)levels.size() - 1 - h))); }
+    void grow(){
+        levels.emplace_back();
+        maxRetained = 0;
+        for(int h=0;h<(int)levels.size();++h) maxRetained += capacity(h);
+    }
+    bool coin(){ rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; return rng & 1; }
+    void compress(){
+        for(size_t h=0; h<levels.size(); ++h){
+            if((int)levels[h].size() < capacity(h)) continue;
+            if(h+1 == levels.size()) grow();
+            auto &cur = levels[h], &up = levels[h+1];
+            sort(cur.begin(), cur.end());
+            size_t keep = cur.size() & 1, off = keep + coin();
+            for(size_t i=off;i<cur.size();i+=2) up.push_back(cur[i]);
+            retained -= cur.size() - keep - (cur.size() - keep) / 2;
+            cur.resize(keep);
+            if(retained < maxRetained) break;
+        }
+    }
+    void add(double v){
+        ++n; mn = min(mn, v); mx = max(mx, v);
+        levels[0].push_back(v);
+        if(++retained >= maxRetained) compress();
+    }
+    void merge(const KLLSketch &o){
+        while(levels.size() < o.levels.size()) grow();
+        for(size_t h=0;h<o.levels.size();++h) levels[h].insert(levels[h].end(), o.levels[h].begin(), o.levels[h].end());
+        n += o.n; mn = min(mn, o.mn); mx = max(mx, o.mx);
+        retained += o.retained;
+        while(retained >= maxRetained){ size_t before = retained; compress(); if(retained == before) break; }
+    }
+    bool exact() const { return levels.size() == 1; }
+    double rank_error() const { return exact() ? 0.0 : 2.296 / pow((double)k, 0.9723); }
+    template<class F> void for_each(F fn) const {
+        for(size_t h=0;h<levels.size();++h) for(double v: levels[h]) fn(v, 1LL << h);
     }
+    double quantile(double q) const {
+        if(n == 0) return 0.0;
+        vector<pair<double,long long>> items;
+        items.reserve(retained);
+        for_each([&](double v, long long w){ items.push_back({v, w}); });
+        sort(items.begin(), items.end());
+        long long total = 0;
+        for(auto &it: items) total += it.second;
+        long long target = max(1LL, (long long)floor(q * total));
+        long long acc = 0;
+        for(auto &it: items){ acc += it.second; if(acc >= target) return it.first; }
+        return items.back().first;
+    }
+};
+
+struct SketchSet {
+    int k = 200;
+    KLLSketch global;
+    unordered_map<int, KLLSketch> byLoc;
+    SketchSet(int k_ = 200): k(k_), global(k_) {}
+    KLLSketch &at(int loc){ return byLoc.try_emplace(loc, k, (uint64_t)loc + 2).first->second; }
+    void merge(const SketchSet &o){
+        global.merge(o.global);
+        for(auto &kv: o.byLoc) at(kv.first).merge(kv.second);
+    }
+};
+
+static SketchSet build_sketches(const TrafficTable &t, int k, int threads){
+    SketchSet set(k);
+    vector<KLLSketch> per(t.groups());
+    atomic<int> next{0};
+    auto work = [&]{
+        for(int g; (g = next++) < t.groups(); ){
+            KLLSketch sk(k, (uint64_t)t.locIds[g] + 2);
+            int m = t.group_size(g);
+            const int *rows = t.group_rows(g);
+            for(int i=0;i<m;++i) sk.add(t.density[rows[i]]);
+            per[g] = move(sk);
+        }
+    };
+    vector<thread> th;
+    for(int i=1;i<threads;++i) th.emplace_back(work);
+    work();
+    for(auto &x: th) x.join();
+    for(int g=0;g<t.groups();++g){ set.global.merge(per[g]); set.byLoc.emplace(t.locIds[g], move(per[g])); }
+    return set;
+}
+
+static SketchSet sketch_file(const string &path, int k, long long &rows){
+    SketchSet set(k);
+    rows = 0;
+    ifstream in(path);
+    string line;
+    if(!in.is_open() || !getline(in,line)) return set;
+    TrafficSchema schema;
+    schema.from_header(line);
+    while(getline(in,line)){
+        string stamp; int loc, dr, veh; double d;
+        if(!schema.parse(line, stamp, loc, dr, veh, d)) continue;
+        set.global.add(d);
+        set.at(loc).add(d);
+        ++rows;
+    }
+    return set;
 }
 
-static vector<Record> sample_uniform(const vector<Record> &rows, int k){
-    if(k <= 0 || rows.empty()) return {};
+static void sketch_histogram(const KLLSketch &sk, int buckets=40){
+    if(sk.n == 0 || sk.mn >= sk.mx){ cout<<"flat\n"; return; }
+    vector<long long> cnt(buckets,0);
+    sk.for_each([&](double v, long long w){ cnt[bucket_of(v, sk.mn, sk.mx, buckets)] += w; });
+    print_buckets(cnt);
+    if(sk.exact()) cout<<"n="<<sk.n<<" exact\n";
+    else cout<<"n="<<sk.n<<" per-bucket error <= "<<(long long)ceil(2 * sk.rank_error() * sk.n)<<" rows (rank error "<<100 * sk.rank_error()<<"%, 99% conf)\n";
+}
+
+static vector<int> sample_uniform(int n, int k){
+    if(k <= 0 || n == 0) return {};
     mt19937_64 rng((uint64_t)chrono::high_resolution_clock::now().time_since_epoch().count());
-    vector<Record> out;
-    int n = rows.size();
-    if(k >= n) return rows;
+    vector<int> out;
+    if(k >= n){ out.resize(n); iota(out.begin(), out.end(), 0); return out; }
     unordered_set<int> sel;
     uniform_int_distribution<int> d(0,n-1);
     while((int)sel.size() < k) sel.insert(d(rng));
-    for(auto idx: sel) out.push_back(rows[idx]);
+    for(auto idx: sel) out.push_back(idx);
     return out;
 }
 
-static vector<Record> sample_stratified(const vector<Record> &rows, int k){
-    if(rows.empty()) return {};
-    vector<Record> sorted = rows;
-    quicksort_inplace(sorted, 0, (int)sorted.size()-1);
+static vector<int> sample_stratified(const vector<int> &sorted, int k){
+    if(sorted.empty()) return {};
     int n = sorted.size();
-    vector<Record> out;
+    vector<int> out;
     for(int i=0;i<k;++i){
         int pos = (int)floor((double)i * n / k);
         out.push_back(sorted[pos]);
@@ -227,75 +632,209 @@ static vector<Record> sample_stratified(const vector<Record> &rows, int k){
     return out;
 }
 
-static void export_csv_records(const string &path, const vector<Record> &rows){
+static void export_csv_records(const string &path, const TrafficTable &t, const vector<int> &rows){
     ofstream out(path);
     out<<"timestamp,location_id,drone_count,vehicle_count,density,index\n";
-    for(auto &r: rows) out<<r.timestamp<<","<<r.location_id<<","<<r.drone_count<<","<<r.vehicle_count<<","<<r.density<<","<<r.index<<"\n";
+    for(int i: rows) out<<t.timestamp(i)<<","<<t.loc[i]<<","<<t.drones[i]<<","<<t.vehicles[i]<<","<<t.density[i]<<","<<i<<"\n";
     out.close();
 }
 
-static void build_index_per_location(const unordered_map<int, vector<Record>> &mp, unordered_map<int, vector<int>> &idxMap){
-    idxMap.clear();
-    for(auto &kv: mp){
-        int loc = kv.first;
-        const auto &vec = kv.second;
-        vector<int> ids; ids.reserve(vec.size());
-        for(auto &r: vec) ids.push_back(r.index);
-        idxMap[loc] = move(ids);
+static vector<pair<int,double>> running_average_per_loc(const TrafficTable &t, int window){
+    vector<pair<int,double>> out;
+    for(int g=0;g<t.groups();++g){
+        int m = t.group_size(g), l = max(0, m - window);
+        const int *rows = t.group_rows(g);
+        double sum = 0;
+        for(int i=l;i<m;++i) sum += t.density[rows[i]];
+        out.push_back({t.locIds[g], m > l ? sum/(m-l) : 0.0});
     }
+    return out;
 }
 
-static vector<pair<int,double>> running_average_per_loc(const unordered_map<int, vector<Record>> &mp, int window){
-    vector<pair<int,double>> out;
-    for(auto &kv: mp){
-        int loc = kv.first;
-        const auto &v = kv.second;
-        deque<double> dq; double sum=0;
-        for(size_t i=0;i<v.size();++i){
-            dq.push_back(v[i].density); sum += v[i].density;
-            if(dq.size() > (size_t)window){ sum -= dq.front(); dq.pop_front(); }
+struct DensityKey {
+    double density;
+    int index;
+    bool operator<(const DensityKey &o) const { return density < o.density || (density == o.density && index < o.index); }
+};
+
+static void parallel_sample_sort(vector<DensityKey> &keys, int threads){
+    int n = keys.size();
+    if(threads <= 1 || n < 20000){ sort(keys.begin(), keys.end()); return; }
+    int p = threads;
+    mt19937 rng(12345);
+    vector<DensityKey> sample(p*32);
+    for(auto &x: sample) x = keys[rng()%n];
+    sort(sample.begin(), sample.end());
+    vector<DensityKey> split(p-1);
+    for(int i=1;i<p;++i) split[i-1] = sample[i*32];
+    int chunk = (n + p - 1) / p;
+    vector<vector<int>> cnt(p, vector<int>(p, 0));
+    vector<int> bucketOf(n);
+    auto run = [&](auto fn){
+        vector<thread> th;
+        for(int t=0;t<p;++t) th.emplace_back(fn, t);
+        for(auto &tt: th) tt.join();
+    };
+    run([&](int t){
+        int l = t*chunk, r = min(n, l+chunk);
+        for(int i=l;i<r;++i){
+            int b = upper_bound(split.begin(), split.end(), keys[i]) - split.begin();
+            bucketOf[i] = b; ++cnt[t][b];
         }
-        double avg = dq.empty()?0.0:sum/dq.size();
-        out.push_back({loc, avg});
+    });
+    vector<int> start(p+1, 0);
+    vector<vector<int>> pos(p, vector<int>(p));
+    for(int b=0, off=0;b<p;++b){
+        start[b] = off;
+        for(int t=0;t<p;++t){ pos[t][b] = off; off += cnt[t][b]; }
     }
-    return out;
+    start[p] = n;
+    vector<DensityKey> out(n);
+    run([&](int t){
+        int l = t*chunk, r = min(n, l+chunk);
+        auto &ps = pos[t];
+        for(int i=l;i<r;++i) out[ps[bucketOf[i]]++] = keys[i];
+    });
+    run([&](int b){ sort(out.begin()+start[b], out.begin()+start[b+1]); });
+    keys.swap(out);
 }
 
-static void multi_threaded_sort(vector<Record> &data, int threads){
-    if(threads <= 1 || data.size() < 20000){ quicksort_inplace(data, 0, (int)data.size()-1); return; }
-    int n = data.size();
-    int chunk = (n + threads - 1) / threads;
-    vector<thread> th;
-    vector<int> L, R;
-    for(int t=0;t<threads;++t){
-        int l = t*chunk;
-        int r = min(n-1, (t+1)*chunk - 1);
-        if(l > r) break;
-        L.push_back(l); R.push_back(r);
-        th.emplace_back([&data,l,r](){ quicksort_inplace(data, l, r); });
-    }
-    for(auto &tt: th) tt.join();
-    vector<Record> tmp;
-    tmp.reserve(n);
-    vector<int> ptr(L.size(), 0);
-    for(size_t i=0;i<L.size();++i) ptr[i] = L[i];
-    auto get_val = [&](int p)->double{ return data[p].density; };
-    while(true){
-        int who=-1; double best=0;
-        for(size_t i=0;i<L.size();++i){
-            if(ptr[i] <= R[i]){
-                double val = get_val(ptr[i]);
-                if(who==-1 || val < best){ who = (int)i; best = val; }
-            }
+static uint64_t density_bits(double d){
+    if(d == 0) d = 0;
+    uint64_t b; memcpy(&b, &d, sizeof b);
+    return (b >> 63) ? ~b : b ^ 0x8000000000000000ULL;
+}
+
+static double density_from_bits(uint64_t b){
+    b = (b >> 63) ? b ^ 0x8000000000000000ULL : ~b;
+    double d; memcpy(&d, &b, sizeof d);
+    return d;
+}
+
+static void radix_sort_keys(vector<DensityKey> &keys, int threads){
+    const int BITS = 11, BUCKETS = 1 << BITS, PASSES = (64 + BITS - 1) / BITS;
+    struct Item { uint64_t bits; int index; };
+    int n = keys.size();
+    if(n < 2) return;
+    int p = max(1, min(threads, n / 65536 + 1));
+    int chunk = (n + p - 1) / p;
+    vector<Item> a(n), b(n);
+    vector<vector<int>> cnt(p, vector<int>(PASSES * BUCKETS, 0));
+    auto run = [&](auto fn){
+        if(p == 1){ fn(0); return; }
+        vector<thread> th;
+        for(int t=0;t<p;++t) th.emplace_back(fn, t);
+        for(auto &tt: th) tt.join();
+    };
+    run([&](int t){
+        int l = t*chunk, r = min(n, l+chunk);
+        auto &c = cnt[t];
+        for(int i=l;i<r;++i){
+            uint64_t k = density_bits(keys[i].density);
+            a[i] = {k, keys[i].index};
+            for(int d=0;d<PASSES;++d) ++c[d*BUCKETS + ((k >> (d*BITS)) & (BUCKETS-1))];
         }
-        if(who==-1) break;
-        tmp.push_back(data[ptr[who]++]);
+    });
+    vector<int> total(PASSES * BUCKETS, 0);
+    for(int t=0;t<p;++t) for(int i=0;i<PASSES*BUCKETS;++i) total[i] += cnt[t][i];
+    vector<vector<int>> pos(p, vector<int>(BUCKETS));
+    bool fresh = true;
+    for(int d=0;d<PASSES;++d){
+        int base = d*BUCKETS, shift = d*BITS;
+        if(*max_element(total.begin()+base, total.begin()+base+BUCKETS) == n) continue;
+        if(!fresh) run([&](int t){
+            int l = t*chunk, r = min(n, l+chunk);
+            auto &c = cnt[t];
+            fill(c.begin()+base, c.begin()+base+BUCKETS, 0);
+            for(int i=l;i<r;++i) ++c[base + ((a[i].bits >> shift) & (BUCKETS-1))];
+        });
+        for(int v=0, off=0;v<BUCKETS;++v)
+            for(int t=0;t<p;++t){ pos[t][v] = off; off += cnt[t][base+v]; }
+        run([&](int t){
+            int l = t*chunk, r = min(n, l+chunk);
+            auto &ps = pos[t];
+            for(int i=l;i<r;++i) b[ps[(a[i].bits >> shift) & (BUCKETS-1)]++] = a[i];
+        });
+        a.swap(b);
+        fresh = p == 1;
     }
-    data.swap(tmp);
+    run([&](int t){
+        int l = t*chunk, r = min(n, l+chunk);
+        for(int i=l;i<r;++i) keys[i] = {density_from_bits(a[i].bits), a[i].index};
+    });
+}
+
+enum class SortEngine { Quick, Std, Sample, Radix };
+
+static bool parse_engine(const string &s, SortEngine &e){
+    if(s=="quick") e = SortEngine::Quick;
+    else if(s=="std") e = SortEngine::Std;
+    else if(s=="sample") e = SortEngine::Sample;
+    else if(s=="radix") e = SortEngine::Radix;
+    else return false;
+    return true;
+}
+
+static const char *engine_name(SortEngine e){
+    switch(e){
+        case SortEngine::Quick: return "quick";
+        case SortEngine::Std: return "std";
+        case SortEngine::Sample: return "sample";
+        default: return "radix";
+    }
+}
+
+static void sort_records(vector<Record> &data, int threads, SortEngine engine){
+    int n = data.size();
+    if(engine == SortEngine::Quick){ quicksort_inplace(data, 0, n-1); return; }
+    if(engine == SortEngine::Std){
+        sort(data.begin(), data.end(), [](const Record&a,const Record&b){ return a.density < b.density; });
+        return;
+    }
+    vector<DensityKey> keys(n);
+    for(int i=0;i<n;++i) keys[i] = {data[i].density, i};
+    if(engine == SortEngine::Radix) radix_sort_keys(keys, threads);
+    else parallel_sample_sort(keys, threads);
+    vector<Record> out;
+    out.reserve(n);
+    for(auto &k: keys) out.push_back(move(data[k.index]));
+    data.swap(out);
+}
+
+static vector<int> density_order(const TrafficTable &t, int threads, SortEngine engine){
+    int n = t.size();
+    vector<int> order(n);
+    if(engine == SortEngine::Quick || engine == SortEngine::Std){
+        auto recs = t.records();
+        sort_records(recs, threads, engine);
+        for(int i=0;i<n;++i) order[i] = recs[i].index;
+        return order;
+    }
+    vector<DensityKey> keys(n);
+    for(int i=0;i<n;++i) keys[i] = {t.density[i], i};
+    if(engine == SortEngine::Radix) radix_sort_keys(keys, threads);
+    else parallel_sample_sort(keys, threads);
+    for(int i=0;i<n;++i) order[i] = keys[i].index;
+    return order;
+}
+
+static vector<Record> synthetic_records(int n){
+    mt19937_64 rng(2024);
+    normal_distribution<double> dist(0.5, 0.2);
+    vector<Record> out(n);
+    for(int i=0;i<n;++i){
+        auto &r = out[i];
+        r.location_id = (int)(rng()%100);
+        r.drone_count = (int)(rng()%20);
+        r.vehicle_count = (int)(rng()%200);
+        r.density = round(max(0.0, dist(rng)) * 1000) / 1000;
+        r.index = i;
+    }
+    return out;
 }
 
 static void print_help(){
-    cout<<"Commands:\ncount\nsummary\nhist\nsort [threads]\nsample u k\nsample s k\ntiers\nbuildfenwick\nrolling loc idx k\nanomaly loc window thresh\nexport out.csv\nbench sort iters threads\nstress n\nexit\n";
+    cout<<"Commands:\ncount\nsummary\nhist [exact|loc id]\nsort [threads] [quick|std|sample|radix]\nsample u k\nsample s k\ntiers [exact|loc id]\nsketch [add file...|reset [k]]\nbuildfenwick\nrolling loc idx k\nanomaly loc window thresh\nanomaly all window thresh [threads]\nanomaly tail file window thresh [idle-seconds]\nexport out.csv\nbench sort iters [threads] [engine|all] [synthetic-n]\nstress n\nexit\n";
 }
 
 int main(int argc,char**argv){
@@ -303,14 +842,19 @@ int main(int argc,char**argv){
     cin.tie(nullptr);
     if(argc < 2){ cerr<<"Usage: "<<argv[0]<<" <csv-path>\n"; return 1; }
     string csv = argv[1];
-    auto rows = load_records(csv);
-    if(rows.empty()){ cerr<<"no data\n"; return 1; }
-    cout<<"Loaded "<<rows.size()<<" records\n";
-    unordered_map<int, vector<Record>> byloc = group_by_location(rows);
-    unordered_map<int, Fenwick> fenw = build_fenwicks(byloc);
-    unordered_map<int, vector<int>> idxMap;
-    build_index_per_location(byloc, idxMap);
-    vector<Record> copyrows = rows;
+    TrafficTable table = load_table(csv);
+    if(table.size() == 0){ cerr<<"no data\n"; return 1; }
+    cout<<"Loaded "<<table.size()<<" records";
+    if(table.tsStyles.size() > 1) cout<<" ("<<table.tsStyles.size()<<" timestamp styles)";
+    if(!table.tsRaw.empty()) cout<<" ("<<table.tsRaw.size()<<" timestamps kept verbatim)";
+    cout<<"\n";
+    vector<Fenwick> fenw = build_fenwicks(table);
+    vector<int> sortedOrder;
+    auto ordered = [&]() -> const vector<int>& {
+        if(sortedOrder.empty()) sortedOrder = density_order(table, max(1u, thread::hardware_concurrency()), SortEngine::Radix);
+        return sortedOrder;
+    };
+    SketchSet sketches = build_sketches(table, 200, max(1u, thread::hardware_concurrency()));
     print_help();
     string line;
     while(true){
@@ -320,45 +864,106 @@ int main(int argc,char**argv){
         stringstream ss(line);
         string cmd; ss>>cmd;
         if(cmd=="exit"||cmd=="quit") break;
-        if(cmd=="count"){ cout<<"records="<<rows.size()<<" locations="<<byloc.size()<<"\n"; continue; }
+        if(cmd=="count"){ cout<<"records="<<table.size()<<" locations="<<table.groups()<<"\n"; continue; }
         if(cmd=="summary"){
-            double mn=1e18,mx=-1e18,mean=0; for(auto &r: rows){ mn=min(mn,r.density); mx=max(mx,r.density); mean+=r.density; }
-            mean /= rows.size();
+            double mn=1e18,mx=-1e18,mean=0; for(double d: table.density){ mn=min(mn,d); mx=max(mx,d); mean+=d; }
+            mean /= table.size();
             cout<<"min="<<mn<<" mean="<<mean<<" max="<<mx<<"\n";
             continue;
         }
-        if(cmd=="hist"){ ascii_histogram(rows); continue; }
+        if(cmd=="hist"){
+            string mode; ss>>mode;
+            if(mode=="exact"){ ascii_histogram(table.density); continue; }
+            if(mode=="loc"){
+                int loc; ss>>loc;
+                auto it = sketches.byLoc.find(loc);
+                if(it == sketches.byLoc.end()){ cout<<"no loc\n"; continue; }
+                sketch_histogram(it->second);
+                continue;
+            }
+            sketch_histogram(sketches.global);
+            continue;
+        }
         if(cmd=="sort"){
-            int threads=1; ss>>threads;
+            int threads=1; string name; ss>>threads>>name;
+            SortEngine engine = SortEngine::Sample;
+            if(!name.empty() && !parse_engine(name, engine)){ cout<<"unknown engine\n"; continue; }
             Timer t; t.start();
-            multi_threaded_sort(copyrows, threads);
+            auto order = density_order(table, threads, engine);
             cout<<"sorted in "<<t.ms()<<" ms\n";
+            if(engine == SortEngine::Sample || engine == SortEngine::Radix) sortedOrder = move(order);
             continue;
         }
         if(cmd=="sample"){
             string mode; ss>>mode;
-            if(mode=="u"){ int k; ss>>k; auto s = sample_uniform(rows, k); export_csv_records("sampled_uniform.csv", s); cout<<"wrote sampled_uniform.csv\n"; continue; }
-            if(mode=="s"){ int k; ss>>k; auto s = sample_stratified(rows, k); export_csv_records("sampled_stratified.csv", s); cout<<"wrote sampled_stratified.csv\n"; continue; }
+            if(mode=="u"){ int k; ss>>k; auto s = sample_uniform(table.size(), k); export_csv_records("sampled_uniform.csv", table, s); cout<<"wrote sampled_uniform.csv\n"; continue; }
+            if(mode=="s"){ int k; ss>>k; auto s = sample_stratified(ordered(), k); export_csv_records("sampled_stratified.csv", table, s); cout<<"wrote sampled_stratified.csv\n"; continue; }
             cout<<"unknown sample mode\n";
             continue;
         }
         if(cmd=="tiers"){
-            vector<Record> tmp = rows;
-            quicksort_inplace(tmp, 0, (int)tmp.size()-1);
-            auto t = compute_tiers(tmp, 0.33, 0.66);
+            string mode; ss>>mode;
+            if(mode=="exact"){
+                auto t = compute_tiers(table.density, ordered(), 0.33, 0.66);
+                cout<<"index,tier\n";
+                for(auto &p: t) cout<<p.first<<","<<p.second<<"\n";
+                continue;
+            }
+            const KLLSketch *sk = &sketches.global;
+            int g = -1;
+            if(mode=="loc"){
+                int loc; ss>>loc;
+                auto it = sketches.byLoc.find(loc);
+                g = table.group_of(loc);
+                if(it == sketches.byLoc.end()){ cout<<"no loc\n"; continue; }
+                sk = &it->second;
+            }
+            double lowThr = sk->quantile(0.33), highThr = sk->quantile(0.66);
+            cout<<"thresholds low="<<lowThr<<" high="<<highThr<<" n="<<sk->n<<" rank error "<<100 * sk->rank_error()<<"%"<<(sk->exact() ? " (exact)" : " (99% conf)")<<"\n";
             cout<<"index,tier\n";
-            for(auto &p: t) cout<<p.first<<","<<p.second<<"\n";
+            auto emit = [&](int i){
+                double d = table.density[i];
+                cout<<i<<","<<((d <= lowThr) ? 0 : (d <= highThr ? 1 : 2))<<"\n";
+            };
+            if(mode=="loc"){ if(g >= 0) for(int j=0;j<table.group_size(g);++j) emit(table.group_rows(g)[j]); }
+            else for(int i=0;i<table.size();++i) emit(i);
+            continue;
+        }
+        if(cmd=="sketch"){
+            string sub; ss>>sub;
+            if(sub=="add"){
+                vector<string> files; string f;
+                while(ss>>f) files.push_back(f);
+                if(files.empty()){ cout<<"sketch add file...\n"; continue; }
+                Timer t; t.start();
+                vector<SketchSet> parts(files.size(), SketchSet(sketches.k));
+                vector<long long> rows(files.size(), 0);
+                vector<thread> th;
+                for(size_t i=0;i<files.size();++i) th.emplace_back([&, i]{ parts[i] = sketch_file(files[i], sketches.k, rows[i]); });
+                for(auto &x: th) x.join();
+                for(size_t i=0;i<files.size();++i){ sketches.merge(parts[i]); cout<<files[i]<<": "<<rows[i]<<" rows\n"; }
+                cout<<"merged in "<<t.ms()<<" ms\n";
+                continue;
+            }
+            if(sub=="reset"){
+                int k = sketches.k; ss>>k;
+                sketches = build_sketches(table, max(8, k), max(1u, thread::hardware_concurrency()));
+                cout<<"rebuilt sketches k="<<sketches.k<<"\n";
+                continue;
+            }
+            cout<<"global n="<<sketches.global.n<<" retained="<<sketches.global.retained<<" locations="<<sketches.byLoc.size()<<" k="<<sketches.k<<" rank error "<<100 * sketches.global.rank_error()<<"%\n";
             continue;
         }
         if(cmd=="buildfenwick"){
-            fenw = build_fenwicks(byloc);
+            fenw = build_fenwicks(table);
             cout<<"built fenwick for "<<fenw.size()<<" locations\n";
             continue;
         }
         if(cmd=="rolling"){
             int loc; int idx; int k; ss>>loc>>idx>>k;
-            if(fenw.find(loc)==fenw.end()){ cout<<"no loc\n"; continue; }
-            auto &f = fenw[loc];
+            int g = table.group_of(loc);
+            if(g < 0 || g >= (int)fenw.size()){ cout<<"no loc\n"; continue; }
+            auto &f = fenw[g];
             int n = f.n;
             if(idx < 0) idx = n-1;
             int l = max(0, idx - k + 1), r = min(n-1, idx);
@@ -367,26 +972,77 @@ int main(int argc,char**argv){
             continue;
         }
         if(cmd=="anomaly"){
-            int loc; int window; double thresh; ss>>loc>>window>>thresh;
-            if(byloc.find(loc)==byloc.end()){ cout<<"no loc\n"; continue; }
-            auto &series = byloc[loc];
-            auto hits = detect_anomalies_zscore(series, window, thresh);
+            string what; ss>>what;
+            if(what=="all"){
+                int window=30; double thresh=3.0; int threads=max(1u, thread::hardware_concurrency()); ss>>window>>thresh>>threads;
+                Timer t; t.start();
+                auto res = detect_anomalies_all(table, window, thresh, max(1, threads));
+                long long total = 0;
+                for(int g=0;g<table.groups();++g)
+                    for(auto &h: res[g]){ cout<<table.locIds[g]<<","<<h.index<<","<<h.value<<","<<h.zscore<<"\n"; ++total; }
+                cout<<total<<" anomalies across "<<table.groups()<<" locations in "<<t.ms()<<" ms\n";
+                continue;
+            }
+            if(what=="tail"){
+                string path; int window=30; double thresh=3.0; double idle=5; ss>>path>>window>>thresh>>idle;
+                if(path.empty()){ cout<<"anomaly tail file window thresh [idle-seconds]\n"; continue; }
+                tail_anomalies(path, window, thresh, (int)(idle*1000));
+                continue;
+            }
+            int loc; int window; double thresh;
+            try { loc = stoi(what); } catch(const exception &){ cout<<"anomaly loc|all|tail ...\n"; continue; }
+            ss>>window>>thresh;
+            int g = table.group_of(loc);
+            if(g < 0){ cout<<"no loc\n"; continue; }
+            auto hits = detect_anomalies_zscore(table, g, window, thresh);
             for(auto &h: hits) cout<<h.index<<","<<h.value<<","<<h.zscore<<"\n";
             continue;
         }
         if(cmd=="export"){
             string out; ss>>out;
             if(out.empty()) { cout<<"export <out.csv>\n"; continue; }
-            export_csv_records(out, rows);
+            vector<int> all(table.size());
+            iota(all.begin(), all.end(), 0);
+            export_csv_records(out, table, all);
             cout<<"wrote "<<out<<"\n";
             continue;
         }
         if(cmd=="bench"){
             string target; ss>>target;
-            if(target=="sort"){ int iters=1; int threads=1; ss>>iters>>threads;
-                Timer t; t.start();
-                for(int i=0;i<iters;++i){ vector<Record> tmp = rows; multi_threaded_sort(tmp, threads); }
-                cout<<"bench sort total "<<t.ms()<<" ms\n"; continue;
+            if(target=="sort"){ int iters=1; int threads=0; string name="sample"; long long synth=0; ss>>iters>>threads>>name>>synth;
+                iters = max(1, iters);
+                vector<SortEngine> engines;
+                SortEngine e;
+                if(name=="all") engines = {SortEngine::Quick, SortEngine::Std, SortEngine::Sample, SortEngine::Radix};
+                else if(parse_engine(name, e)) engines.push_back(e);
+                else { cout<<"unknown engine\n"; continue; }
+                vector<Record> src;
+                if(synth > 0){
+                    src = synthetic_records((int)min<long long>(synth, INT_MAX));
+                    cout<<"synthetic "<<src.size()<<" records\n";
+                } else src = table.records();
+                int hw = max(1u, thread::hardware_concurrency());
+                double base = 0;
+                for(SortEngine eng: engines){
+                    vector<int> counts;
+                    if(eng == SortEngine::Quick || eng == SortEngine::Std) counts.push_back(1);
+                    else if(threads > 0) counts.push_back(threads);
+                    else { for(int c=1;c<hw;c*=2) counts.push_back(c); counts.push_back(hw); }
+                    for(int c: counts){
+                        vector<Record> tmp;
+                        chrono::duration<double,milli> total(0);
+                        for(int i=0;i<iters;++i){
+                            tmp = src;
+                            auto t0 = chrono::high_resolution_clock::now();
+                            sort_records(tmp, c, eng);
+                            total += chrono::high_resolution_clock::now() - t0;
+                        }
+                        double ms = total.count() / iters;
+                        if(base == 0) base = ms;
+                        cout<<"engine="<<engine_name(eng)<<" threads="<<c<<" avg "<<ms<<" ms speedup "<<base/max(ms,1e-9)<<"x\n";
+                    }
+                }
+                continue;
             }
             cout<<"unknown bench\n";
             continue;
@@ -398,22 +1054,17 @@ int main(int argc,char**argv){
             for(int i=0;i<n;++i){
                 int op = (int)(rng()%5);
                 if(op==0){
-                    int loc = (int)(rng()%100);
-                    vector<Record> s = sample_uniform(rows, min(100, (int)rows.size()));
-                    sort(s.begin(), s.end(), [](const Record&a,const Record&b){ return a.density < b.density; });
+                    vector<int> s = sample_uniform(table.size(), min(100, table.size()));
+                    sort(s.begin(), s.end(), [&](int a,int b){ return table.density[a] < table.density[b]; });
                 } else if(op==1){
-                    vector<Record> s = sample_stratified(rows, min(100, (int)rows.size()));
+                    vector<int> s = sample_stratified(density_order(table, 1, SortEngine::Radix), min(100, table.size()));
                 } else if(op==2){
-                    vector<Record> tmp = rows;
-                    multi_threaded_sort(tmp, 2);
+                    vector<int> order = density_order(table, 2, SortEngine::Sample);
                 } else if(op==3){
-                    if(!byloc.empty()){
-                        auto it = byloc.begin();
-                        advance(it, rng()%byloc.size());
-                        auto hits = detect_anomalies_zscore(it->second, 10, 3.0);
-                    }
+                    auto hits = detect_anomalies_zscore(table, (int)(rng()%table.groups()), 10, 3.0);
                 } else {
-                    vector<Record> s = sample_uniform(rows, 10);
+                    vector<double> s;
+                    for(int r: sample_uniform(table.size(), 10)) s.push_back(table.density[r]);
                     ascii_histogram(s);
                 }
             }
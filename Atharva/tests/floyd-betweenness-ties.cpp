@@ -0,0 +1,69 @@
+#define main floyd_main
+#include "../floyd-distribution(case-8).cpp"
+#undef main
+
+static vector<D> betweenness_of(int n, const vector<Edge> &E, ThreadPool &pool){
+    CSR g, rev;
+    g.build(n, E);
+    vector<Edge> rE;
+    for(auto &e: E) rE.emplace_back(e.v, e.u, e.w);
+    rev.build(n, rE);
+    Centrality c;
+    c.compute_betweenness(g, rev, pool);
+    return c.betweenness;
+}
+
+static vector<D> brute_betweenness(int n, const vector<Edge> &E){
+    vector<vector<D>> d(n, vector<D>(n, INF));
+    for(int i=0;i<n;++i) d[i][i] = 0;
+    for(auto &e: E) if(e.u != e.v) d[e.u][e.v] = min(d[e.u][e.v], e.w);
+    for(int k=0;k<n;++k) for(int i=0;i<n;++i) for(int j=0;j<n;++j)
+        if(d[i][k] < INF && d[k][j] < INF) d[i][j] = min(d[i][j], d[i][k] + d[k][j]);
+    vector<vector<D>> paths(n, vector<D>(n, 0));
+    function<D(int,int)> count = [&](int s, int t) -> D {
+        if(s == t) return 1;
+        D c = 0;
+        for(auto &e: E) if(e.v == t && e.u != t && d[s][e.u] < INF && d[s][e.u] + e.w == d[s][t]) c += count(s, e.u);
+        return c;
+    };
+    for(int s=0;s<n;++s) for(int t=0;t<n;++t) if(d[s][t] < INF) paths[s][t] = count(s, t);
+    vector<D> bc(n, 0);
+    for(int s=0;s<n;++s) for(int t=0;t<n;++t) for(int v=0;v<n;++v){
+        if(v == s || v == t || s == t || d[s][t] >= INF || d[s][v] >= INF || d[v][t] >= INF) continue;
+        if(d[s][v] + d[v][t] == d[s][t]) bc[v] += paths[s][v] * paths[v][t] / paths[s][t];
+    }
+    return bc;
+}
+
+static int failures = 0;
+
+static void expect(const string &name, const vector<D> &got, const vector<D> &want){
+    for(size_t i=0;i<want.size();++i) if(fabs(got[i] - want[i]) > 1e-9 * max((D)1, fabs(want[i]))){
+        cout<<"FAIL "<<name<<" node "<<i<<" got "<<got[i]<<" want "<<want[i]<<"\n";
+        ++failures;
+        return;
+    }
+}
+
+int main(){
+    ThreadPool pool(2);
+    expect("zero-weight tie", betweenness_of(3, {{0,1,1},{0,2,1},{2,1,0}}, pool), {0, 0, 0.5});
+    expect("negative-weight tie", betweenness_of(4, {{0,1,-1},{0,2,-1},{2,1,0},{3,0,5}}, pool), {2, 0, 1, 0});
+    mt19937 rng(7);
+    for(int it=0;it<200;++it){
+        int n = 3 + rng()%7;
+        vector<int> pot(n);
+        for(auto &p: pot) p = rng()%4;
+        vector<Edge> E;
+        int m = n + rng()%(2*n);
+        for(int i=0;i<m;++i){
+            int u = rng()%n, v = rng()%n;
+            if(u == v) continue;
+            int base = u < v ? rng()%3 : 1 + rng()%2;
+            E.emplace_back(u, v, base + pot[u] - pot[v]);
+        }
+        expect("random #" + to_string(it), betweenness_of(n, E, pool), brute_betweenness(n, E));
+    }
+    cout<<(failures ? "betweenness ties: FAILED" : "betweenness ties: ok")<<"\n";
+    return failures ? 1 : 0;
+}